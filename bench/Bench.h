@@ -0,0 +1,47 @@
+#ifndef BENCH_H
+#define BENCH_H
+#include <memory>
+#include <vector>
+
+#include <SDL2/SDL.h>
+
+class UIManager;
+
+
+inline constexpr int BENCH_WIDTH  = 1280;
+inline constexpr int BENCH_HEIGHT = 720;
+
+struct BenchOptions {
+    int warmupFrames = 60;
+    int frames = 600;
+    const char *fontPath = nullptr;
+    bool softCompositing = false;
+};
+
+// global operator new calls since start, counted by bench_main.cpp
+std::size_t benchAllocations();
+
+// A synthetic widget tree driven by scripted input; every run gets a fresh UIManager.
+class BenchScene {
+public:
+    virtual ~BenchScene() = default;
+
+    virtual const char *name() const = 0;
+    // false if the scene can not run with the given options
+    virtual bool build(UIManager &manager, const BenchOptions &options) = 0;
+    // input events and programmatic changes of one frame, called before UIManager::step
+    virtual void script(UIManager &manager, int frame) = 0;
+    // after the UIManager is destroyed, frees what the scene owns besides the main widget
+    virtual void teardown() {}
+};
+
+std::vector<std::unique_ptr<BenchScene>> makeBenchScenes();
+void runDispatchBench();
+void runCompositorBench();
+
+// scripted input, coordinates are in window space
+void pushMouseMotion(int x, int y, int relX, int relY, bool leftPressed);
+void pushMouseButton(bool pressed, int x, int y);
+
+
+#endif // BENCH_H
@@ -0,0 +1,88 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include "Bench.h"
+#include "SoftCompositor.h"
+
+// Layer blending on the CPU: SDL's surface blitter (what the software renderer runs for
+// every blended copy) against the SoftCompositor kernels, which must agree bit for bit.
+
+static constexpr int LAYERS      = 8;
+static constexpr int LAYER_SIZE  = 384;
+static constexpr int RUNS        = 60;
+
+// premultiplied, half of the layer translucent
+static void fillLayer(SoftImage &image, Uint32 seed) {
+    image.resize(LAYER_SIZE, LAYER_SIZE);
+    for (Uint32 &pixel : image.pixels) {
+        seed = seed * 1664525u + 1013904223u;
+        Uint32 alpha = (seed >> 24) & 1 ? 255 : (seed >> 16) & 0xff;
+        Uint32 r = (seed & 0xff) * alpha / 255, g = ((seed >> 8) & 0xff) * alpha / 255;
+        pixel = alpha << 24 | r << 16 | g << 8 | (seed >> 4 & 0xff) * alpha / 255;
+    }
+}
+
+template <typename Body>
+static double measureMs(Body body) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < RUNS; i++) body();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count() / RUNS;
+}
+
+void runCompositorBench() {
+    std::vector<SoftImage> layers(LAYERS);
+    for (int i = 0; i < LAYERS; i++) fillLayer(layers[i], 777u * (i + 1));
+
+    auto layerX = [](int i) { return 40 + i * 100; };
+    auto layerY = [](int i) { return 20 + i * 30; };
+    const Uint8 opacity = 200;
+    const SDL_Rect screen = {0, 0, BENCH_WIDTH, BENCH_HEIGHT};
+    const SDL_Color background = {40, 40, 40, 255};
+
+    std::printf("\nlayer composition, %d layers of %dx%d at opacity %d, %dx%d frame\n",
+                LAYERS, LAYER_SIZE, LAYER_SIZE, opacity, BENCH_WIDTH, BENCH_HEIGHT);
+
+    // SDL blends straight alpha, the numbers are comparable but the pixels are not
+    SDL_Surface *frame = SDL_CreateRGBSurfaceWithFormat(0, BENCH_WIDTH, BENCH_HEIGHT, 32, SDL_PIXELFORMAT_ARGB8888);
+    std::vector<SDL_Surface *> surfaces;
+    for (SoftImage &image : layers) {
+        SDL_Surface *surface = SDL_CreateRGBSurfaceWithFormat(0, LAYER_SIZE, LAYER_SIZE, 32, SDL_PIXELFORMAT_ARGB8888);
+        for (int y = 0; y < LAYER_SIZE; y++) {
+            std::copy_n(image.row(y), LAYER_SIZE, reinterpret_cast<Uint32 *>(static_cast<Uint8 *>(surface->pixels) + y * surface->pitch));
+        }
+        SDL_SetSurfaceBlendMode(surface, SDL_BLENDMODE_BLEND);
+        SDL_SetSurfaceAlphaMod(surface, opacity);
+        surfaces.push_back(surface);
+    }
+
+    double sdlMs = measureMs([&] {
+        SDL_FillRect(frame, nullptr, 0xff282828u);
+        for (int i = 0; i < LAYERS; i++) {
+            SDL_Rect dst = {layerX(i), layerY(i), LAYER_SIZE, LAYER_SIZE};
+            SDL_BlitSurface(surfaces[i], nullptr, frame, &dst);
+        }
+    });
+    std::printf("  %-14s : %8.3f ms/frame\n", "SDL blitter", sdlMs);
+
+    for (SDL_Surface *surface : surfaces) SDL_FreeSurface(surface);
+    SDL_FreeSurface(frame);
+
+    std::vector<Uint32> reference;
+    for (SimdLevel level : {SimdLevel::SCALAR, SimdLevel::SSE41, SimdLevel::AVX2, SimdLevel::NEON}) {
+        if (!simdLevelSupported(level)) continue;
+
+        SoftCompositor compositor(BENCH_WIDTH, BENCH_HEIGHT, level);
+        double ms = measureMs([&] {
+            compositor.fill(screen, background);
+            for (int i = 0; i < LAYERS; i++) compositor.blendImage(layers[i], layerX(i), layerY(i), screen, opacity);
+        });
+
+        const std::vector<Uint32> &pixels = compositor.frame().pixels;
+        if (reference.empty()) reference = pixels;
+        std::printf("  %-14s : %8.3f ms/frame  %.2fx  %s\n", simdLevelName(level), ms, sdlMs / ms,
+                    pixels == reference ? "identical" : "MISMATCH");
+    }
+}
@@ -0,0 +1,74 @@
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include "Bench.h"
+#include "Container.h"
+#include "Events.h"
+#include "PointerDispatcher.h"
+
+// Pointer dispatch on deep trees: the legacy global-state walk followed by the
+// propagation walk against the fused single-pass PointerDispatcher.
+
+static constexpr int TREE_DEPTH       = 32;
+static constexpr int SIBLINGS         = 8;
+static constexpr int EVENTS_PER_RUN   = 200000;
+
+static Container *buildDeepTree(int depth) {
+    Container *root = new Container(2048, 2048);
+    Container *level = root;
+    for (int d = 0; d < depth; d++) {
+        Container *next = new Container(2048 - 2 * (d + 1), 2048 - 2 * (d + 1));
+        level->addWidget(1, 1, next);
+        for (int s = 1; s < SIBLINGS; s++) level->addWidget(1, 1, new Widget(64, 64));
+        level = next;
+    }
+    return root;
+}
+
+// copy of the pre-fusion UIManager::globalStateOnMouseDown
+static void legacyGlobalStateOnMouseDown(Widget *wgt, const MouseButtonEvent &event, Widget **active) {
+    if (!isInsideRect(wgt->rect(), event.pos.x, event.pos.y)) return;
+    if (event.button == SDL_BUTTON_LEFT) *active = wgt;
+
+    for (auto it = wgt->getChildren().rbegin(); it != wgt->getChildren().rend(); ++it) {
+        MouseButtonEvent childLocal = event;
+        childLocal.pos.x -= wgt->rect().x;
+        childLocal.pos.y -= wgt->rect().y;
+        legacyGlobalStateOnMouseDown(*it, childLocal, active);
+    }
+}
+
+template <typename Body>
+static double measureNs(Body body) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < EVENTS_PER_RUN; i++) body(i);
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / EVENTS_PER_RUN;
+}
+
+void runDispatchBench() {
+    Container *root = buildDeepTree(TREE_DEPTH);
+    Widget *sink = nullptr;
+
+    double legacyNs = measureNs([&](int i) {
+        MouseButtonEvent event(1000 + (i & 7), 1000, SDL_BUTTON_LEFT);
+        legacyGlobalStateOnMouseDown(root, event, &sink);
+        root->onMouseDown(event);
+    });
+
+    PointerDispatcher dispatcher;
+    double fusedNs = measureNs([&](int i) {
+        MouseButtonEvent event(1000 + (i & 7), 1000, SDL_BUTTON_LEFT);
+        dispatcher.hitTest(root, event.pos);
+        sink = dispatcher.target();
+        dispatcher.mouseDown(event);
+    });
+
+    std::printf("\npointer dispatch, depth %d, %d siblings per level\n", TREE_DEPTH, SIBLINGS);
+    std::printf("  legacy two-pass : %8.1f ns/event\n", legacyNs);
+    std::printf("  fused one-pass  : %8.1f ns/event\n", fusedNs);
+    std::printf("  speedup         : %8.2fx\n", legacyNs / fusedNs);
+
+    delete root;
+}
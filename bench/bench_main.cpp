@@ -0,0 +1,139 @@
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include <SDL2/SDL.h>
+
+#include "Bench.h"
+#include "UIManager.h"
+
+// Headless benchmark suite: each scene runs on SDL's dummy video driver with the software
+// renderer, so numbers are comparable between CI machines without a GPU.
+//   mygui_bench [--frames N] [--warmup N] [--font path.ttf] [--soft] [scene...]
+// --soft runs the scenes with UIManager::setSoftwareCompositing.
+// MYGUI_BENCH_FONT may be used instead of --font; the text scene is skipped without a font.
+
+static std::atomic<std::size_t> allocationsCount{0};
+
+void *operator new(std::size_t size) {
+    allocationsCount.fetch_add(1, std::memory_order_relaxed);
+    if (void *ptr = std::malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+
+std::size_t benchAllocations() { return allocationsCount.load(std::memory_order_relaxed); }
+
+struct SceneResult {
+    double fps = 0;
+    FrameTimings average{};
+    double allocationsPerFrame = 0;
+    double stateCallsPerFrame = 0;   // SDL state setters and getters issued
+    double stateSkippedPerFrame = 0; // setters avoided by the RenderState shadow
+};
+
+static bool runScene(BenchScene &scene, const BenchOptions &options, SceneResult &result) {
+    // SDL_Quit in the previous UIManager cleared the hints
+    SDL_SetHintWithPriority(SDL_HINT_RENDER_DRIVER, "software", SDL_HINT_DEFAULT);
+
+    bool built = false;
+    {
+        UIManager manager(BENCH_WIDTH, BENCH_HEIGHT, 0);
+        if (options.softCompositing) manager.setSoftwareCompositing(true);
+        built = scene.build(manager, options);
+
+        if (built) {
+            int frame = 0;
+            for (; frame < options.warmupFrames; frame++) {
+                scene.script(manager, frame);
+                manager.step();
+            }
+
+            FrameTimings total{};
+            std::size_t allocationsStart = benchAllocations();
+            manager.renderState().resetCounters();
+            Uint64 start = SDL_GetPerformanceCounter();
+
+            for (int i = 0; i < options.frames; i++, frame++) {
+                scene.script(manager, frame);
+                manager.step();
+
+                const FrameTimings &timings = manager.frameTimings();
+                total.eventsMs += timings.eventsMs;
+                total.updateMs += timings.updateMs;
+                total.renderMs += timings.renderMs;
+                total.presentMs += timings.presentMs;
+            }
+
+            double seconds = static_cast<double>(SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+            result.fps = options.frames / seconds;
+            result.average.eventsMs = total.eventsMs / options.frames;
+            result.average.updateMs = total.updateMs / options.frames;
+            result.average.renderMs = total.renderMs / options.frames;
+            result.average.presentMs = total.presentMs / options.frames;
+            result.allocationsPerFrame = static_cast<double>(benchAllocations() - allocationsStart) / options.frames;
+
+            const RenderState &state = manager.renderState();
+            result.stateCallsPerFrame = static_cast<double>(state.issuedCalls() + state.queriedCalls()) / options.frames;
+            result.stateSkippedPerFrame = static_cast<double>(state.skippedCalls()) / options.frames;
+        }
+    }
+    scene.teardown();
+
+    return built;
+}
+
+int main(int argc, char *argv[]) {
+    BenchOptions options;
+    options.fontPath = std::getenv("MYGUI_BENCH_FONT");
+    std::vector<const char *> selected;
+
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "--frames") && i + 1 < argc) options.frames = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--warmup") && i + 1 < argc) options.warmupFrames = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--font") && i + 1 < argc) options.fontPath = argv[++i];
+        else if (!std::strcmp(argv[i], "--soft")) options.softCompositing = true;
+        else selected.push_back(argv[i]);
+    }
+    if (options.frames < 1) options.frames = 1;
+
+    // an explicitly set driver wins, e.g. to measure on a real GPU
+    SDL_setenv("SDL_VIDEODRIVER", "dummy", 0);
+
+    std::printf("%d frames per scene after %d warmup frames, %dx%d, %s compositing\n",
+                options.frames, options.warmupFrames, BENCH_WIDTH, BENCH_HEIGHT,
+                options.softCompositing ? "software" : "SDL");
+    std::printf("%-8s %10s %10s %10s %10s %10s %14s %14s %14s\n",
+                "scene", "fps", "events ms", "update ms", "render ms", "present ms", "allocs/frame",
+                "state calls/f", "skipped/f");
+
+    for (std::unique_ptr<BenchScene> &scene : makeBenchScenes()) {
+        bool wanted = selected.empty();
+        for (const char *name : selected) wanted |= !std::strcmp(name, scene->name());
+        if (!wanted) continue;
+
+        SceneResult result;
+        if (!runScene(*scene, options, result)) {
+            std::printf("%-8s skipped\n", scene->name());
+            continue;
+        }
+
+        std::printf("%-8s %10.1f %10.3f %10.3f %10.3f %10.3f %14.1f %14.1f %14.1f\n", scene->name(), result.fps,
+                    result.average.eventsMs, result.average.updateMs, result.average.renderMs,
+                    result.average.presentMs, result.allocationsPerFrame,
+                    result.stateCallsPerFrame, result.stateSkippedPerFrame);
+    }
+
+    bool dispatchWanted = selected.empty();
+    for (const char *name : selected) dispatchWanted |= !std::strcmp(name, "dispatch");
+    if (dispatchWanted) runDispatchBench();
+
+    bool compositorWanted = selected.empty();
+    for (const char *name : selected) compositorWanted |= !std::strcmp(name, "compositor");
+    if (compositorWanted) runCompositorBench();
+
+    return 0;
+}
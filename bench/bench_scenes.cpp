@@ -0,0 +1,270 @@
+#include <string>
+#include <cstdio>
+
+#include <SDL2/SDL_ttf.h>
+
+#include "Bench.h"
+#include "UIManager.h"
+#include "Container.h"
+#include "Window.h"
+
+// Synthetic trees: wide grids, deep nesting, modal overlays and text-heavy labels.
+
+namespace {
+
+// deterministic, the same frames are invalidated on every run
+struct Lcg {
+    Uint32 state = 12345;
+    Uint32 next() { return state = state * 1664525u + 1013904223u; }
+};
+
+class BenchTile : public Widget {
+    SDL_Color color_;
+
+public:
+    BenchTile(int w, int h, SDL_Color color) : Widget(w, h), color_(color) { setOpaque(true); }
+
+    void renderSelfAction(SDL_Renderer* renderer) override {
+        SDL_Rect full = {0, 0, rect_.w, rect_.h};
+        SDL_SetRenderDrawColor(renderer, color_.r, color_.g, color_.b, 255);
+        SDL_RenderFillRect(renderer, &full);
+        SDL_SetRenderDrawColor(renderer, 20, 20, 20, 255);
+        SDL_RenderDrawRect(renderer, &full);
+    }
+
+    void shift() {
+        color_.r += 17;
+        invalidate();
+    }
+};
+
+class BenchLabel : public Widget {
+    TTF_Font *font_;
+    std::string text_;
+
+public:
+    BenchLabel(int w, int h, TTF_Font *font) : Widget(w, h), font_(font) {}
+
+    void renderSelfAction(SDL_Renderer* renderer) override {
+        UIManager_->glyphAtlas().drawText(font_, text_.c_str(), 2, 2, {230, 230, 230, 255});
+    }
+
+    void setText(std::string text) {
+        text_ = std::move(text);
+        invalidate();
+    }
+};
+
+// mixes solid widgets (batched fills) with tiles drawn by renderSelfAction
+static void fillWithTiles(Container *parent, int originY, int cols, int rows, int size, std::vector<BenchTile *> *tiles) {
+    for (int row = 0; row < rows; row++) {
+        for (int col = 0; col < cols; col++) {
+            Widget *wgt = nullptr;
+            if ((row + col) % 2) {
+                BenchTile *tile = new BenchTile(size - 2, size - 2, {Uint8(col * 4), Uint8(row * 7), 160, 255});
+                if (tiles) tiles->push_back(tile);
+                wgt = tile;
+            }
+            else {
+                wgt = new Widget(size - 2, size - 2);
+                wgt->setSolidFill(true);
+            }
+            parent->addWidget(col * size + 1, originY + row * size + 1, wgt);
+        }
+    }
+}
+
+// dashboard of 2304 tiles with a window dragged over it
+class GridScene : public BenchScene {
+    static constexpr int TILE = 20;
+    static constexpr int DRAG_PERIOD = 240;
+
+    std::vector<BenchTile *> tiles_;
+    Window *window_ = nullptr;
+    Lcg random_;
+
+public:
+    const char *name() const override { return "grid"; }
+
+    bool build(UIManager &manager, const BenchOptions &options) override {
+        tiles_.clear();
+        Container *root = new Container(BENCH_WIDTH, BENCH_HEIGHT);
+        root->enableSpatialIndex();
+        fillWithTiles(root, 0, BENCH_WIDTH / TILE, BENCH_HEIGHT / TILE, TILE, &tiles_);
+
+        // tiles below the title strip, presses on the strip reach the window itself
+        window_ = new Window(320, 240);
+        window_->setSolidFill(true);
+        window_->setLayer(true); // the drag only moves the layer
+        fillWithTiles(window_, 24, 320 / TILE, 216 / TILE, TILE, nullptr);
+        root->addWidget(100, 100, window_);
+
+        manager.setMainWidget(0, 0, root);
+        return true;
+    }
+
+    void script(UIManager &manager, int frame) override {
+        for (int i = 0; i < 32; i++) tiles_[random_.next() % tiles_.size()]->shift();
+
+        Rect rect = window_->rect();
+        int phase = frame % DRAG_PERIOD;
+        int dx = phase < DRAG_PERIOD / 2 ? 3 : -3;
+        if (phase == 0) pushMouseButton(true, rect.x + 10, rect.y + 8);
+        else if (phase == DRAG_PERIOD - 1) pushMouseButton(false, rect.x + 10, rect.y + 8);
+        else pushMouseMotion(rect.x + 10 + dx, rect.y + 8 + 1, dx, 1, true);
+    }
+};
+
+// 48 nested containers with tiles on every level, clicks and hovers on the deepest one
+class DeepScene : public BenchScene {
+    static constexpr int DEPTH = 48;
+
+    BenchTile *deepest_ = nullptr;
+
+public:
+    const char *name() const override { return "deep"; }
+
+    bool build(UIManager &manager, const BenchOptions &options) override {
+        Container *root = new Container(BENCH_WIDTH, BENCH_HEIGHT);
+        Container *level = root;
+        for (int d = 0; d < DEPTH; d++) {
+            Rect rect = level->rect();
+            Container *next = new Container(rect.w - 12, rect.h - 12);
+            level->addWidget(6, 6, next);
+            for (int s = 0; s < 4; s++) level->addWidget(s * 7, 0, new BenchTile(6, 5, {90, Uint8(d * 5), 40, 255}));
+            level = next;
+        }
+
+        deepest_ = new BenchTile(40, 40, {200, 200, 40, 255});
+        level->addWidget(10, 10, deepest_);
+        manager.setMainWidget(0, 0, root);
+        return true;
+    }
+
+    void script(UIManager &manager, int frame) override {
+        int x = DEPTH * 6 + 30, y = DEPTH * 6 + 30;
+        pushMouseMotion(x + frame % 5, y, 1, 0, false);
+        if (frame % 2 == 0) pushMouseButton(true, x, y);
+        else pushMouseButton(false, x, y);
+        deepest_->shift();
+    }
+};
+
+// 24 overlapping modal windows moved by the animator
+class ModalScene : public BenchScene {
+    static constexpr int MODALS = 24;
+
+    std::vector<Window *> modals_;
+
+public:
+    const char *name() const override { return "modals"; }
+
+    bool build(UIManager &manager, const BenchOptions &options) override {
+        Container *root = new Container(BENCH_WIDTH, BENCH_HEIGHT);
+        fillWithTiles(root, 0, BENCH_WIDTH / 40, BENCH_HEIGHT / 40, 40, nullptr);
+        manager.setMainWidget(0, 0, root);
+
+        for (int i = 0; i < MODALS; i++) {
+            Window *modal = new Window(300, 200);
+            modal->setSolidFill(true);
+            modal->setLayer(true); // moved as a whole, its own texture is blitted
+            fillWithTiles(modal, 24, 300 / 25, 175 / 25, 25, nullptr);
+            manager.pushModalWidget(40 + i * 30, 30 + i * 20, modal);
+            modals_.push_back(modal);
+        }
+        return true;
+    }
+
+    void script(UIManager &manager, int frame) override {
+        pushMouseMotion(frame % BENCH_WIDTH, (frame * 3) % BENCH_HEIGHT, 1, 3, false);
+
+        if (frame % 60) return;
+        for (std::size_t i = 0; i < modals_.size(); i += 3) {
+            Window *modal = modals_[(i + frame / 60) % modals_.size()];
+            Rect rect = modal->rect();
+            manager.animator().moveTo(modal, (rect.x + 200) % (BENCH_WIDTH - 300), rect.y, 500);
+        }
+    }
+
+    void teardown() override {
+        // modal widgets are owned by the user
+        for (Window *modal : modals_) delete modal;
+        modals_.clear();
+    }
+};
+
+// 480 labels, 48 of them change their text every frame
+class TextScene : public BenchScene {
+    std::vector<BenchLabel *> labels_;
+    TTF_Font *font_ = nullptr;
+    Lcg random_;
+
+public:
+    const char *name() const override { return "text"; }
+
+    bool build(UIManager &manager, const BenchOptions &options) override {
+        if (!options.fontPath) return false;
+        font_ = TTF_OpenFont(options.fontPath, 14);
+        if (!font_) {
+            std::fprintf(stderr, "TTF_OpenFont: %s\n", TTF_GetError());
+            return false;
+        }
+
+        labels_.clear();
+        Container *root = new Container(BENCH_WIDTH, BENCH_HEIGHT);
+        for (int row = 0; row < BENCH_HEIGHT / 18; row++) {
+            for (int col = 0; col < BENCH_WIDTH / 106; col++) {
+                BenchLabel *label = new BenchLabel(104, 16, font_);
+                label->setText("label " + std::to_string(row) + ":" + std::to_string(col));
+                root->addWidget(col * 106, row * 18, label);
+                labels_.push_back(label);
+            }
+        }
+        manager.setMainWidget(0, 0, root);
+        return true;
+    }
+
+    void script(UIManager &manager, int frame) override {
+        for (int i = 0; i < 48; i++) {
+            labels_[random_.next() % labels_.size()]->setText("value " + std::to_string(random_.next() % 100000));
+        }
+    }
+
+    void teardown() override {
+        // glyphs are cached per font, the atlas went away with the UIManager
+        if (font_) TTF_CloseFont(font_);
+        font_ = nullptr;
+    }
+};
+
+} // namespace
+
+std::vector<std::unique_ptr<BenchScene>> makeBenchScenes() {
+    std::vector<std::unique_ptr<BenchScene>> scenes;
+    scenes.push_back(std::make_unique<GridScene>());
+    scenes.push_back(std::make_unique<DeepScene>());
+    scenes.push_back(std::make_unique<ModalScene>());
+    scenes.push_back(std::make_unique<TextScene>());
+    return scenes;
+}
+
+void pushMouseMotion(int x, int y, int relX, int relY, bool leftPressed) {
+    SDL_Event event = {};
+    event.type = SDL_MOUSEMOTION;
+    event.motion.x = x;
+    event.motion.y = y;
+    event.motion.xrel = relX;
+    event.motion.yrel = relY;
+    event.motion.state = leftPressed ? SDL_BUTTON_LMASK : 0;
+    SDL_PushEvent(&event);
+}
+
+void pushMouseButton(bool pressed, int x, int y) {
+    SDL_Event event = {};
+    event.type = pressed ? SDL_MOUSEBUTTONDOWN : SDL_MOUSEBUTTONUP;
+    event.button.button = SDL_BUTTON_LEFT;
+    event.button.state = pressed ? SDL_PRESSED : SDL_RELEASED;
+    event.button.x = x;
+    event.button.y = y;
+    SDL_PushEvent(&event);
+}
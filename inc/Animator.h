@@ -0,0 +1,58 @@
+#ifndef ANIMATOR_H
+#define ANIMATOR_H
+#include <vector>
+#include <functional>
+
+#include <SDL2/SDL.h>
+
+class Widget;
+
+
+enum class Easing {
+    LINEAR,
+    EASE_IN,
+    EASE_OUT,
+    EASE_IN_OUT
+};
+
+enum class AnimatedProperty {
+    X,
+    Y,
+    OPACITY
+};
+
+// Tweens compositor properties of widgets, ticked by the UIManager update pass.
+// Animating layers costs blits only, the widget textures are not re-rendered.
+class Animator {
+    struct Track {
+        Widget *widget;
+        AnimatedProperty property;
+        float from, to;
+        Uint32 startMs, durationMs;
+        Easing easing;
+        std::function<void()> onFinished;
+    };
+
+    std::vector<Track> tracks_;
+
+    static float ease(Easing easing, float t);
+    static float currentValue(const Widget *widget, AnimatedProperty property);
+    static void apply(Widget *widget, AnimatedProperty property, float value);
+
+public:
+    // starts from the current value, replaces a running track of the same widget property
+    void animate(Widget *widget, AnimatedProperty property, float to, Uint32 durationMs,
+                 Easing easing = Easing::EASE_OUT, std::function<void()> onFinished = nullptr);
+    void moveTo(Widget *widget, int x, int y, Uint32 durationMs, Easing easing = Easing::EASE_OUT);
+    void fadeTo(Widget *widget, Uint8 opacity, Uint32 durationMs, Easing easing = Easing::EASE_OUT,
+                std::function<void()> onFinished = nullptr);
+    // drops the tracks without finishing them
+    void cancel(Widget *widget);
+
+    // returns true if anything changed
+    bool update(Uint32 nowMs);
+    bool active() const { return !tracks_.empty(); }
+};
+
+
+#endif // ANIMATOR_H
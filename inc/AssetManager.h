@@ -0,0 +1,101 @@
+#ifndef ASSET_MANAGER_H
+#define ASSET_MANAGER_H
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <functional>
+#include <unordered_map>
+
+#include <SDL2/SDL.h>
+#include "ThreadPool.h"
+
+class AssetManager;
+
+
+inline constexpr Uint32 DEFAULT_ASSET_UPLOAD_BUDGET_MS = 2;
+inline constexpr std::size_t DEFAULT_ASSET_WORKERS = 2;
+
+enum class AssetState {
+    LOADING,    // queued or being decoded on a worker
+    DECODED,    // surface is ready, waiting for upload on the render thread
+    READY,
+    FAILED
+};
+
+struct ImageAsset {
+    std::string path;
+    std::atomic<AssetState> state{AssetState::LOADING};
+    SDL_Surface *surface = nullptr;
+    SDL_Texture *texture = nullptr;
+    int refCount = 0;     // render thread only
+    bool settled = false; // render thread only, passed through uploadPending
+    std::vector<std::function<void()>> onReady;
+};
+
+// ref-counted handle to a shared image, texture() is the placeholder until the asset is uploaded
+class ImageHandle {
+    AssetManager *manager_ = nullptr;
+    ImageAsset *asset_ = nullptr;
+
+    ImageHandle(AssetManager *manager, ImageAsset *asset);
+
+public:
+    ImageHandle() = default;
+    ImageHandle(const ImageHandle &other);
+    ImageHandle(ImageHandle &&other) noexcept;
+    ImageHandle &operator=(ImageHandle other);
+    ~ImageHandle();
+
+    SDL_Texture *texture() const;
+    bool ready() const;
+    bool failed() const;
+    // runs on the render thread once the texture is uploaded, immediately if it already is
+    void onReady(std::function<void()> callback) const;
+
+    void reset();
+    explicit operator bool() const { return asset_ != nullptr; }
+
+    friend class AssetManager;
+};
+
+// Deduplicates images by path, decodes them on worker threads and uploads
+// the decoded surfaces on the render thread within a per-frame time budget.
+class AssetManager {
+    SDL_Renderer *renderer_ = nullptr;
+    SDL_Texture *placeholder_ = nullptr;
+    Uint32 wakeEventType_ = 0;
+
+    std::unordered_map<std::string, std::unique_ptr<ImageAsset>> assets_;
+
+    std::mutex decodedMutex_;
+    std::vector<ImageAsset *> decoded_;     // filled by the workers
+    std::vector<ImageAsset *> uploadQueue_; // render thread only
+
+    ThreadPool workers_;
+
+    void acquire(ImageAsset *asset) { asset->refCount++; }
+    void release(ImageAsset *asset);
+    void destroy(ImageAsset *asset);
+    void decode(ImageAsset *asset);
+
+public:
+    AssetManager(SDL_Renderer *renderer, std::size_t workers = DEFAULT_ASSET_WORKERS);
+    ~AssetManager();
+    AssetManager(const AssetManager &) = delete;
+    AssetManager &operator=(const AssetManager &) = delete;
+
+    ImageHandle loadImage(const char *path);
+
+    // uploads decoded images until the budget is spent, returns the number uploaded
+    std::size_t uploadPending(Uint32 budgetMs = DEFAULT_ASSET_UPLOAD_BUDGET_MS);
+    bool hasPendingUploads();
+
+    SDL_Texture *placeholder() const { return placeholder_; }
+
+    friend class ImageHandle;
+};
+
+
+#endif // ASSET_MANAGER_H
@@ -11,6 +11,7 @@ inline constexpr SDL_Color BLACK_SDL_COLOR = {0, 0, 0, 255};
 inline constexpr SDL_Color RED_SDL_COLOR = {255, 0, 0, 255};
 inline constexpr SDL_Color BLUE_SDL_COLOR = {0, 0, 255, 255};
 inline constexpr SDL_Color WHITE_SDL_COLOR = {255, 255, 255, 255};
+inline constexpr SDL_Color DEFAULT_BACKGROUND_COLOR = {50, 50, 50, 255};
 
 SDL_Rect getTextSize(TTF_Font *font, const char text[]);
 SDL_Texture* createTexture(const char *texturePath, SDL_Renderer* renderer);
@@ -25,6 +26,7 @@ struct Rect : public SDL_Rect {
         this->w = w;
         this->h = h;
     }
+    Rect(const SDL_Rect &rect): Rect(rect.x, rect.y, rect.w, rect.h) {}
     gm_dot<int, 2> pos() {
         return { x, y };
     }
@@ -39,6 +41,14 @@ inline bool isInsideRect(const Rect& rect, const int x, const int y) {
     return (x >= rect.x) && (x < rect.x + rect.w) && (y >= rect.y) && (y < rect.y + rect.h);
 }
 
+// fills rect with transparent pixels; unlike SDL_RenderClear respects the clip rect
+inline void clearRenderRect(SDL_Renderer *renderer, const SDL_Rect &rect) {
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+    SDL_RenderFillRect(renderer, &rect);
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+}
+
 inline bool isMouseSDLevent(const SDL_Event &event) {
     return 
         event.type == SDL_MOUSEMOTION       || 
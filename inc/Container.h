@@ -1,17 +1,51 @@
 #ifndef CONTAINER_H
 #define CONTAINER_H
 #include <vector>
+#include <memory>
 
 #include <SDL2/SDL.h>
 #include "Common.h"
 #include "Widget.h"
+#include "SpatialGrid.h"
 
 class UIManager;
 
+// opaque rects remembered per cull pass, the largest ones are kept
+inline constexpr std::size_t MAX_OCCLUDERS = 8;
 
 class Container : public Widget {
 protected:
     std::vector<Widget *> children_;
+    std::unique_ptr<SpatialGrid> spatialIndex_;
+    // result of the last cullChildren, parallel to children_
+    std::vector<char> culled_;
+    // children with something to update, idle ones are removed lazily by update()
+    std::vector<Widget *> tickList_;
+    // tick the children on the update pool, see setIndependentChildren
+    bool independentChildren_ = false;
+    // per tickList_ entry, written by the parallel tick
+    std::vector<char> tickResults_;
+
+    void childRectChanged(Widget *child, const Rect &oldRect) override;
+    void childWantsUpdate(Widget *child) override;
+    // stable, moves the first count entries of tickList_ to the front of children_
+    void raiseUpdatedChildren(std::size_t count);
+    // updates the first count entries of tickList_ concurrently into tickResults_
+    void updateChildrenParallel(std::size_t count);
+
+    // marks the children that are hidden, layers, outside bounds or covered by an opaque
+    // sibling above them; returns true if a single opaque child covers the whole bounds
+    bool cullChildren(int originX, int originY, const SDL_Rect &bounds);
+    // self at dst and the children left by cullChildren, limited to bounds;
+    // clip is the current renderer clip rect
+    void composeContent(SDL_Renderer* renderer, RenderBatch &batch, const SDL_Rect &dst,
+                        const SDL_Rect &bounds, const SDL_Rect &clip);
+
+    // topmost child containing (x, y) among the children from sibling index first on
+    Widget *childAtFrom(int x, int y, std::size_t first) const;
+    // calls visit for the children containing (x, y) from top to bottom until one consumes
+    template <typename Visitor>
+    bool visitChildrenAt(int x, int y, Visitor visit);
      
 public:
     Container(int width, int height, Widget *parent=nullptr);
@@ -24,13 +58,24 @@ public:
 
     // Stages
     bool update() override;
+    bool needsUpdate() const override { return wantsUpdate_ || !tickList_.empty(); }
     bool render(SDL_Renderer* renderer) override;
+    void composeInto(SDL_Renderer* renderer, RenderBatch &batch, const SDL_Rect &dst, const SDL_Rect &clip) override;
 
     // Getters / setters
     const std::vector<Widget *> &getChildren() const override;
+    Widget *childAt(int x, int y) const override;
+    Widget *childBelowAt(const Widget *above, int x, int y) const override;
 
     // User API
     void addWidget(int x, int y, Widget *widget);
+    // grid over child rects for hit-testing, worth it for containers with many children
+    void enableSpatialIndex(int cellSize = DEFAULT_SPATIAL_CELL_SIZE);
+    void disableSpatialIndex() { spatialIndex_.reset(); }
+    // the children's update() touch nothing outside their own subtree (no shared model,
+    // no siblings), so they may run on worker threads; the z-order raise stays sequential
+    void setIndependentChildren(bool independent) { independentChildren_ = independent; }
+    bool independentChildren() const { return independentChildren_; }
 };
 
 
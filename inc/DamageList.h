@@ -0,0 +1,32 @@
+#ifndef DAMAGE_LIST_H
+#define DAMAGE_LIST_H
+#include <vector>
+
+#include <SDL2/SDL.h>
+#include "Common.h"
+
+
+inline constexpr std::size_t MAX_DAMAGE_RECTS = 8;
+
+// set of damaged sub-rectangles in local coordinates, clipped to [0, w) x [0, h)
+class DamageList {
+    std::vector<Rect> rects_;
+    Rect bounds_;
+    bool full_ = false;
+
+public:
+    DamageList(int width = 0, int height = 0);
+
+    void setBounds(int width, int height);
+    void add(const SDL_Rect &rect);
+    void addFull();
+    void clear();
+
+    bool empty() const { return rects_.empty(); }
+    bool isFull() const { return full_; }
+    const std::vector<Rect> &rects() const { return rects_; }
+    Rect boundingRect() const;
+};
+
+
+#endif // DAMAGE_LIST_H
@@ -0,0 +1,62 @@
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+#include <SDL2/SDL.h>
+
+
+// below this the OS sleep is not trusted, the rest of the wait spins on the counter
+inline constexpr double DEFAULT_PACER_SPIN_MS = 2.0;
+
+// counted since the last resetStats()
+struct FramePacingStats {
+    Uint64 frames = 0;
+    Uint64 missedFrames = 0;   // deadlines (or vblanks with vsync) that passed without a frame
+    double worstDeltaMs = 0;   // longest interval between two frame starts
+    double worstLatenessMs = 0; // how far a frame overran its deadline at worst
+};
+
+// Paces frames on the performance counter: beginFrame() measures the delta, wait() sleeps
+// most of the time left until the deadline and spins the rest. Deadlines advance by the
+// target, a late frame moves them forward instead of bursting to catch up. With vsync
+// the present already blocks, only targets longer than the refresh interval are waited for.
+class FramePacer {
+    double ticksPerMs_;
+    double targetMs_;
+    double spinMs_ = DEFAULT_PACER_SPIN_MS;
+    bool vsync_ = false;
+    double refreshMs_ = 0; // 0: unknown
+
+    Uint64 frameStart_ = 0;
+    Uint64 deadline_ = 0;
+    bool resumed_ = true;
+    double deltaMs_ = 0;
+    FramePacingStats stats_{};
+
+    Uint64 toTicks(double ms) const { return static_cast<Uint64>(ms * ticksPerMs_); }
+    double toMs(Uint64 ticks) const { return ticks / ticksPerMs_; }
+    double intervalMs() const;
+
+public:
+    explicit FramePacer(double targetMs);
+
+    void setTargetMs(double targetMs) { targetMs_ = targetMs; }
+    double targetMs() const { return targetMs_; }
+    void setSpinMs(double spinMs) { spinMs_ = spinMs; }
+    // refreshMs is the display's vblank interval, 0 if unknown
+    void setVSync(bool vsync, double refreshMs);
+    bool vsync() const { return vsync_; }
+
+    void beginFrame();
+    // blocks until the frame's deadline, counts a missed frame if it is already gone
+    void wait();
+    // the loop slept on purpose (waiting for events), the next delta is not a miss
+    void resume() { resumed_ = true; }
+
+    // measured between the last two beginFrame() calls
+    double deltaMs() const { return deltaMs_; }
+    const FramePacingStats &stats() const { return stats_; }
+    void resetStats() { stats_ = {}; }
+};
+
+
+#endif // FRAME_PACER_H
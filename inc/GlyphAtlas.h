@@ -0,0 +1,82 @@
+#ifndef GLYPH_ATLAS_H
+#define GLYPH_ATLAS_H
+#include <vector>
+#include <unordered_map>
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+
+
+inline constexpr int GLYPH_ATLAS_PAGE_SIZE = 1024;
+inline constexpr int GLYPH_ATLAS_PADDING   = 1;
+
+// Glyph cache per (font, size, style): every glyph is rasterized once into a shared
+// atlas texture, text is drawn as batched quads with cached advance and kerning.
+class GlyphAtlas {
+    struct Glyph {
+        int page = -1;      // -1 for glyphs without pixels (spaces)
+        SDL_Rect src = {0, 0, 0, 0};
+        int offsetX = 0;    // where the glyph surface starts relative to the pen
+        int advance = 0;
+    };
+
+    struct FontKey {
+        TTF_Font *font;
+        int height;
+        int style;
+        bool operator==(const FontKey &other) const {
+            return font == other.font && height == other.height && style == other.style;
+        }
+    };
+
+    struct FontKeyHash {
+        std::size_t operator()(const FontKey &key) const;
+    };
+
+    struct FontCache {
+        std::unordered_map<Uint32, Glyph> glyphs;
+        std::unordered_map<Uint64, int> kerning;
+        int height = 0;
+    };
+
+    struct Page {
+        SDL_Texture *texture = nullptr;
+        int shelfX = 0;
+        int shelfY = 0;
+        int shelfH = 0;
+    };
+
+    SDL_Renderer *renderer_ = nullptr;
+    std::vector<Page> pages_;
+    std::unordered_map<FontKey, FontCache, FontKeyHash> fonts_;
+
+    // batch of the page currently being drawn
+    std::vector<SDL_Vertex> vertices_;
+    std::vector<int> indices_;
+    int batchPage_ = -1;
+
+    FontCache &fontCache(TTF_Font *font);
+    const Glyph &glyph(TTF_Font *font, FontCache &cache, Uint32 codepoint);
+    int kerning(TTF_Font *font, FontCache &cache, Uint32 prev, Uint32 cur);
+    bool packGlyph(SDL_Surface *surface, Glyph &glyph);
+    void addPage();
+    void flush();
+
+public:
+    explicit GlyphAtlas(SDL_Renderer *renderer);
+    ~GlyphAtlas();
+    GlyphAtlas(const GlyphAtlas &) = delete;
+    GlyphAtlas &operator=(const GlyphAtlas &) = delete;
+
+    // same result as getTextSize without reshaping the string
+    SDL_Rect measure(TTF_Font *font, const char text[]);
+    // draws UTF-8 text into the current render target, returns the covered rect
+    SDL_Rect drawText(TTF_Font *font, const char text[], int x, int y, SDL_Color color);
+
+    // drop cached metrics before the font is closed, atlas pixels stay until clear()
+    void forgetFont(TTF_Font *font);
+    void clear();
+};
+
+
+#endif // GLYPH_ATLAS_H
@@ -0,0 +1,54 @@
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+#include <atomic>
+#include <utility>
+
+
+// Vyukov's node-based multi-producer single-consumer queue: push is wait-free (one exchange)
+// from any thread, pop is lock-free and must be called from one consumer thread only.
+// A push in progress may stay invisible to pop until the producer links its node.
+template <typename T>
+class MpscQueue {
+    struct Node {
+        std::atomic<Node *> next{nullptr};
+        T value{};
+    };
+
+    std::atomic<Node *> head_; // last pushed, producers
+    Node *tail_;               // consumed stub, consumer
+
+public:
+    MpscQueue() : head_(new Node), tail_(head_.load(std::memory_order_relaxed)) {}
+    ~MpscQueue() {
+        T value;
+        while (pop(value)) {}
+        delete tail_;
+    }
+    MpscQueue(const MpscQueue &) = delete;
+    MpscQueue &operator=(const MpscQueue &) = delete;
+
+    void push(T value) {
+        Node *node = new Node;
+        node->value = std::move(value);
+        Node *prev = head_.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    bool pop(T &value) {
+        Node *tail = tail_;
+        Node *next = tail->next.load(std::memory_order_acquire);
+        if (!next) return false;
+
+        // next becomes the new stub
+        value = std::move(next->value);
+        tail_ = next;
+        delete tail;
+        return true;
+    }
+
+    // consumer side, a concurrent push may be missed
+    bool empty() const { return !tail_->next.load(std::memory_order_acquire); }
+};
+
+
+#endif // MPSC_QUEUE_H
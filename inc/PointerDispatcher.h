@@ -0,0 +1,50 @@
+#ifndef POINTER_DISPATCHER_H
+#define POINTER_DISPATCHER_H
+#include <vector>
+
+#include <SDL2/SDL.h>
+#include "Events.h"
+
+class Widget;
+
+
+struct HitPathEntry {
+    Widget *widget;
+    gm_dot<int, 2> origin; // screen position of the widget's parent coordinate space
+};
+
+// Single-pass pointer dispatch: the root-to-leaf hit path is computed once per event,
+// then capture handlers run root -> leaf and self actions bubble leaf -> root. A level
+// whose hit child propagated first offers the event to the overlapped siblings under it
+// (their subtrees bubble the same way), as the recursive propagation walk did.
+// Layers are composited above all the other content of their top-level widget, so the
+// plain walks skip them; hitTestLayer() builds the path through one layer instead.
+class PointerDispatcher {
+    std::vector<HitPathEntry> path_;
+
+    static Widget *contentChild(const Widget *parent, Widget *child, int x, int y);
+    void descend(Widget *wgt, gm_dot<int, 2> origin, const gm_dot<int, 2> &pos);
+
+    template <typename Event>
+    static bool bubbleSubtree(Widget *wgt, const gm_dot<int, 2> &origin, const Event &event,
+                              bool (Widget::*bubble)(const Event &));
+    template <typename Event>
+    bool dispatch(const Event &event,
+                  bool (Widget::*capture)(const Event &),
+                  bool (Widget::*bubble)(const Event &)) const;
+
+public:
+    void hitTest(Widget *root, const gm_dot<int, 2> &pos);
+    // the caller checked that the layer's visible screen rect contains pos
+    void hitTestLayer(Widget *layer, const gm_dot<int, 2> &pos);
+
+    bool mouseDown(const MouseButtonEvent &event) const;
+    bool mouseUp(const MouseButtonEvent &event) const;
+    bool mouseMove(const MouseMotionEvent &event) const;
+
+    const std::vector<HitPathEntry> &path() const { return path_; }
+    Widget *target() const { return path_.empty() ? nullptr : path_.back().widget; }
+};
+
+
+#endif // POINTER_DISPATCHER_H
@@ -0,0 +1,122 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+#include <atomic>
+#include <memory>
+#include <ostream>
+#include <typeinfo>
+
+#include <SDL2/SDL.h>
+
+
+inline constexpr std::size_t PROFILER_SAMPLES_CAPACITY = 1 << 16; // power of two
+inline constexpr std::size_t PROFILER_FRAMES_CAPACITY = 1024;
+
+struct FrameStats {
+    std::size_t frames = 0;
+    double p50Ms = 0;
+    double p99Ms = 0;
+    double maxMs = 0;
+};
+
+// Collects timed scopes from any thread into a lock-free ring buffer (oldest samples are
+// overwritten) and frame times for the percentile summary. Scopes are recorded only through
+// the MYGUI_PROFILE_* macros, which compile to nothing unless MYGUI_ENABLE_PROFILER is defined.
+class Profiler {
+    struct Sample {
+        std::atomic<Uint64> sequence{0}; // index + 1 once the slot is completely written
+        const char *name = nullptr;
+        const char *detail = nullptr;
+        const void *object = nullptr;
+        Uint64 start = 0;
+        Uint64 duration = 0;
+        Uint32 thread = 0;
+    };
+
+    std::unique_ptr<Sample[]> samples_;
+    std::atomic<Uint64> head_{0};
+
+    // written by the main thread only
+    double frames_[PROFILER_FRAMES_CAPACITY] = {};
+    std::size_t framesCount_ = 0;
+    Uint64 frameStart_ = 0;
+
+    Uint64 origin_;
+    double ticksPerUs_;
+    std::atomic<bool> widgetScopes_{false};
+
+    Profiler();
+
+public:
+    static Profiler &instance();
+    Profiler(const Profiler &) = delete;
+    Profiler &operator=(const Profiler &) = delete;
+
+    static Uint64 now() { return SDL_GetPerformanceCounter(); }
+    static Uint32 threadIndex();
+
+    void record(const char *name, const char *detail, const void *object, Uint64 start, Uint64 end);
+    // bracket the work of one frame in the UIManager loop, idle waits and pacing delays are not counted
+    void frameBegin() { frameStart_ = now(); }
+    void frameEnd();
+
+    // scopes around render/update/event handlers of every widget, off by default. "render"
+    // covers the redraw of cached and layer textures; direct widgets draw in "compose" and
+    // a container's children in its "composeContent", wherever the composition starts from
+    void setWidgetScopes(bool enabled) { widgetScopes_.store(enabled, std::memory_order_relaxed); }
+    bool widgetScopes() const { return widgetScopes_.load(std::memory_order_relaxed); }
+
+    FrameStats frameStats() const;
+    void printSummary(std::ostream &out) const;
+    // chrome://tracing / Perfetto "X" events of the samples still in the ring buffer
+    bool writeChromeTrace(const char *path) const;
+    // main thread, while no other thread is recording
+    void clear();
+};
+
+class ProfileScope {
+    const char *name_;
+    const char *detail_;
+    const void *object_;
+    Uint64 start_;
+    bool enabled_;
+
+public:
+    ProfileScope(const char *name, const char *detail = nullptr, const void *object = nullptr, bool enabled = true)
+        : name_(name), detail_(detail), object_(object), start_(0), enabled_(enabled)
+    {
+        // the first instance() sets the trace origin, it must not come after start_
+        if (enabled_) {
+            Profiler::instance();
+            start_ = Profiler::now();
+        }
+    }
+    ~ProfileScope() {
+        if (enabled_) Profiler::instance().record(name_, detail_, object_, start_, Profiler::now());
+    }
+    ProfileScope(const ProfileScope &) = delete;
+    ProfileScope &operator=(const ProfileScope &) = delete;
+};
+
+#define MYGUI_PROFILE_CONCAT_IMPL(a, b) a##b
+#define MYGUI_PROFILE_CONCAT(a, b) MYGUI_PROFILE_CONCAT_IMPL(a, b)
+
+#ifdef MYGUI_ENABLE_PROFILER
+#define MYGUI_PROFILE_SCOPE(label) \
+    ProfileScope MYGUI_PROFILE_CONCAT(profileScope, __LINE__)(label)
+// needs <typeinfo>, the widget type is only looked up when widget scopes are enabled
+#define MYGUI_PROFILE_WIDGET_SCOPE(label, widget) \
+    bool MYGUI_PROFILE_CONCAT(profileOn, __LINE__) = Profiler::instance().widgetScopes(); \
+    ProfileScope MYGUI_PROFILE_CONCAT(profileScope, __LINE__)(label, \
+        MYGUI_PROFILE_CONCAT(profileOn, __LINE__) ? typeid(*(widget)).name() : nullptr, (widget), \
+        MYGUI_PROFILE_CONCAT(profileOn, __LINE__))
+#define MYGUI_PROFILE_FRAME_BEGIN() Profiler::instance().frameBegin()
+#define MYGUI_PROFILE_FRAME_END() Profiler::instance().frameEnd()
+#else
+#define MYGUI_PROFILE_SCOPE(label) ((void)0)
+#define MYGUI_PROFILE_WIDGET_SCOPE(label, widget) ((void)0)
+#define MYGUI_PROFILE_FRAME_BEGIN() ((void)0)
+#define MYGUI_PROFILE_FRAME_END() ((void)0)
+#endif
+
+
+#endif // PROFILER_H
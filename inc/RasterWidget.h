@@ -0,0 +1,68 @@
+#ifndef RASTER_WIDGET_H
+#define RASTER_WIDGET_H
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <functional>
+
+#include <SDL2/SDL.h>
+#include "Common.h"
+#include "Widget.h"
+
+// draws area of a width x height SDL_PIXELFORMAT_ARGB8888 buffer, pitch is in pixels;
+// the pixels outside area hold the previous raster
+using RasterFunction = std::function<void(Uint32 *pixels, int pitch, const Rect &area)>;
+
+// Widget drawn on the CPU by worker threads (charts, heatmaps, waveforms). The UI thread
+// only uploads the redrawn area into a streaming texture; the previous image stays on screen
+// until the new one is ready.
+class RasterWidget : public Widget {
+    // shared with the job, a destroyed widget just drops it
+    struct RasterBuffer {
+        std::vector<Uint32> pixels;
+        int width = 0;
+        int height = 0;
+        Rect area;
+        std::atomic<bool> ready{false};
+    };
+
+    std::shared_ptr<RasterBuffer> buffer_;
+    bool rasterizing_ = false;
+    bool rasterPending_ = false;
+    // a start posted to the UI thread from a parallel update, the closure checks lifetime_
+    bool startPosted_ = false;
+    std::shared_ptr<RasterWidget *> lifetime_;
+    Rect pendingArea_;
+
+    SDL_Texture *streamTexture_ = nullptr;
+    SDL_Renderer *streamRenderer_ = nullptr;
+    int streamWidth_ = 0;
+    int streamHeight_ = 0;
+    bool hasPixels_ = false; // streamTexture_ holds a complete raster
+
+    void startRaster();
+    void uploadRaster(SDL_Renderer* renderer);
+
+protected:
+    // UI thread: returns the closure drawing the current state, it runs on a worker thread
+    // and must only read what it captured
+    virtual RasterFunction prepareRaster() = 0;
+
+    void renderSelfAction(SDL_Renderer* renderer) override;
+    bool updateSelfAction() override;
+
+public:
+    RasterWidget(int width, int height, Widget *parent=nullptr);
+    ~RasterWidget();
+
+    // redraw rect (local coordinates, nullptr for all) off-thread, requests made while
+    // a raster is running are merged into the next one
+    void requestRaster(const SDL_Rect *rect = nullptr);
+    bool rasterizing() const { return rasterizing_; }
+
+    bool render(SDL_Renderer* renderer) override;
+    void composeInto(SDL_Renderer* renderer, RenderBatch &batch, const SDL_Rect &dst, const SDL_Rect &clip) override;
+};
+
+
+#endif // RASTER_WIDGET_H
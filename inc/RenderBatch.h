@@ -0,0 +1,42 @@
+#ifndef RENDER_BATCH_H
+#define RENDER_BATCH_H
+#include <vector>
+
+#include <SDL2/SDL.h>
+#include "RenderState.h"
+
+
+// Queues rect fills and textured quads, submits them with one SDL_RenderGeometry
+// call per run of geometry sharing the same texture (nullptr for fills).
+class RenderBatch {
+    RenderState &state_;
+    SDL_Renderer *renderer_ = nullptr;
+    SDL_Texture *texture_ = nullptr;
+    std::vector<SDL_Vertex> vertices_;
+    std::vector<int> indices_;
+
+    std::size_t drawCalls_ = 0;
+    std::size_t quads_ = 0;
+
+    void pushQuad(const SDL_Rect &dst, SDL_Color color, float u0, float v0, float u1, float v1);
+
+public:
+    explicit RenderBatch(RenderState &state);
+    ~RenderBatch();
+    RenderBatch(const RenderBatch &) = delete;
+    RenderBatch &operator=(const RenderBatch &) = delete;
+
+    void fillRect(const SDL_Rect &rect, SDL_Color color);
+    void copy(SDL_Texture *texture, const SDL_Rect &src, const SDL_Rect &dst, Uint8 alpha = 255);
+    // must be called before any direct SDL drawing or render target/clip change
+    void flush();
+    // untextured geometry is blended with the draw blend mode, set it through here
+    RenderState &state() { return state_; }
+
+    std::size_t drawCalls() const { return drawCalls_; }
+    std::size_t quads() const { return quads_; }
+    void resetCounters() { drawCalls_ = 0; quads_ = 0; }
+};
+
+
+#endif // RENDER_BATCH_H
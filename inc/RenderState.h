@@ -0,0 +1,103 @@
+#ifndef RENDER_STATE_H
+#define RENDER_STATE_H
+#include <vector>
+
+#include <SDL2/SDL.h>
+
+
+// Shadow of the renderer's target, draw color, blend mode, viewport and clip rect.
+// Setters only record the wanted value, apply() issues the SDL calls for the values that
+// really differ right before something is drawn; push()/pop() replace RendererGuard.
+// Code drawing behind its back must call forget() (or forgetDrawState()).
+class RenderState {
+public:
+    enum Field : Uint8 {
+        TARGET   = 1 << 0,
+        COLOR    = 1 << 1,
+        BLEND    = 1 << 2,
+        VIEWPORT = 1 << 3,
+        CLIP     = 1 << 4,
+        ALL      = TARGET | COLOR | BLEND | VIEWPORT | CLIP,
+        // what geometry and texture copies depend on
+        GEOMETRY = TARGET | BLEND | VIEWPORT | CLIP
+    };
+
+private:
+    struct State {
+        SDL_Texture *target = nullptr;
+        SDL_Color color{};
+        SDL_BlendMode blend = SDL_BLENDMODE_NONE;
+        bool hasViewport = false; // false: whole target
+        SDL_Rect viewport{};
+        bool hasClip = false;     // false: no clipping
+        SDL_Rect clip{};
+    };
+
+    SDL_Renderer *renderer_;
+    State wanted_;
+    State applied_;
+    Uint8 known_ = 0;   // fields of wanted_ that are set, the others are left as they are
+    Uint8 synced_ = 0;  // fields of applied_ that match the renderer
+    Uint8 pending_ = 0; // fields set since their last apply
+    std::vector<State> stack_;
+
+    std::size_t skipped_ = 0;
+    std::size_t issued_ = 0;
+    std::size_t queried_ = 0;
+
+    void query(Uint8 fields);
+    bool needsIssue(Field field, bool same);
+    void request(Field field);
+
+public:
+    explicit RenderState(SDL_Renderer *renderer);
+    // applies what is still pending, e.g. the values restored by the last pop()
+    ~RenderState() { apply(); }
+    RenderState(const RenderState &) = delete;
+    RenderState &operator=(const RenderState &) = delete;
+
+    SDL_Renderer *renderer() const { return renderer_; }
+
+    void setTarget(SDL_Texture *target);
+    void setDrawColor(SDL_Color color);
+    void setBlendMode(SDL_BlendMode mode);
+    // nullptr: the whole target
+    void setViewport(const SDL_Rect *rect);
+    // relative to the viewport, nullptr disables clipping
+    void setClipRect(const SDL_Rect *rect);
+
+    // must precede every draw call made outside of RenderState, fields limits it to
+    // what the call depends on
+    void apply(Uint8 fields = ALL);
+    // fills rect with transparent black, the blend mode is left as BLEND
+    void clearRect(const SDL_Rect &rect);
+
+    // saves the five values, pop() restores them (applied with the next draw or by apply())
+    void push();
+    void pop();
+
+    // the renderer was used directly, nothing is known anymore
+    void forget() { known_ = synced_ = 0; }
+    // after renderSelfAction, which may change the color and blend mode;
+    // it has to leave the target, viewport and clip rect as it found them
+    void forgetDrawState() { synced_ &= ~(COLOR | BLEND); }
+
+    // SDL setter calls made, setter calls that needed none and getter calls made
+    std::size_t issuedCalls() const { return issued_; }
+    std::size_t skippedCalls() const { return skipped_; }
+    std::size_t queriedCalls() const { return queried_; }
+    void resetCounters() { skipped_ = issued_ = queried_ = 0; }
+};
+
+class RenderStateScope {
+    RenderState &state_;
+
+public:
+    explicit RenderStateScope(RenderState &state) : state_(state) { state_.push(); }
+    ~RenderStateScope() { state_.pop(); }
+    RenderStateScope(const RenderStateScope &) = delete;
+    RenderStateScope &operator=(const RenderStateScope &) = delete;
+};
+
+
+#endif // RENDER_STATE_H
@@ -0,0 +1,84 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+#include <vector>
+#include <functional>
+
+#include <SDL2/SDL.h>
+
+
+inline constexpr int SCHEDULER_LEVELS = 4;
+inline constexpr int SCHEDULER_SLOT_BITS = 6; // 64 slots per level, 1 ms resolution, ~4.6 h span
+
+// 0 is never a valid id, a default constructed handle refers to nothing
+struct TimerHandle {
+    Uint64 id = 0;
+    explicit operator bool() const { return id != 0; }
+};
+
+// Hierarchical timer wheel: scheduling and cancelling are O(1), advancing only touches the
+// slots that come due. Callbacks receive the milliseconds since they were scheduled
+// (one-shot) or last ran (repeating).
+class Scheduler {
+public:
+    using Callback = std::function<void(Uint32 deltaMs)>;
+
+private:
+    static constexpr int SLOTS = 1 << SCHEDULER_SLOT_BITS;
+    static constexpr Sint32 NONE = -1;
+
+    // pooled, linked into a wheel slot or the next-frame list by index
+    struct Timer {
+        Callback callback;
+        Uint64 deadline = 0;
+        Uint64 lastRun = 0;
+        Uint32 period = 0; // 0 for one-shot
+        Uint32 generation = 1;
+        Sint32 prev = NONE, next = NONE;
+        Sint32 *list = nullptr; // head of the slot it is linked into
+        bool active = false;
+    };
+
+    std::vector<Timer> timers_;
+    std::vector<Sint32> free_;
+    Sint32 wheel_[SCHEDULER_LEVELS][SLOTS];
+    Sint32 nextFrame_ = NONE;
+    Uint64 now_;
+    std::size_t pending_ = 0;
+
+    // reused between advances
+    std::vector<Sint32> due_;
+
+    Sint32 allocate(Callback callback, Uint32 period);
+    void release(Sint32 index);
+    void link(Sint32 index, Sint32 *list);
+    void unlink(Sint32 index);
+    void insert(Sint32 index);
+    void cascade(int level);
+    void collect(Sint32 *list);
+    void run(Sint32 index);
+    Timer *find(TimerHandle handle);
+    const Timer *find(TimerHandle handle) const;
+
+public:
+    explicit Scheduler(Uint64 nowMs = 0);
+    Scheduler(const Scheduler &) = delete;
+    Scheduler &operator=(const Scheduler &) = delete;
+
+    TimerHandle after(Uint32 delayMs, Callback callback);
+    TimerHandle every(Uint32 periodMs, Callback callback);
+    // runs on the next advance() whatever the time
+    TimerHandle postToNextFrame(Callback callback);
+    // false if the timer already ran or was cancelled; the handle is reset
+    bool cancel(TimerHandle &handle);
+    bool active(TimerHandle handle) const { return find(handle) != nullptr; }
+
+    // runs the callbacks due up to nowMs, returns how many ran
+    std::size_t advance(Uint64 nowMs);
+    // time left until the earliest pending callback, false if none is pending
+    bool timeUntilNext(Uint64 nowMs, Uint32 &ms) const;
+    std::size_t pending() const { return pending_; }
+    Uint64 now() const { return now_; }
+};
+
+
+#endif // SCHEDULER_H
@@ -0,0 +1,63 @@
+#ifndef SOFT_COMPOSITOR_H
+#define SOFT_COMPOSITOR_H
+#include <vector>
+
+#include <SDL2/SDL.h>
+#include "Common.h"
+
+enum class SimdLevel { SCALAR, SSE41, AVX2, NEON };
+
+// span kernels on premultiplied SDL_PIXELFORMAT_ARGB8888 pixels; every level rounds
+// exactly like SCALAR, so the output does not depend on the machine
+struct CompositeKernels {
+    // dst = src * opacity + dst * (1 - srcAlpha * opacity)
+    void (*blend)(Uint32 *dst, const Uint32 *src, int count, Uint8 opacity);
+};
+
+// best level of this CPU
+SimdLevel detectSimdLevel();
+bool simdLevelSupported(SimdLevel level);
+const char *simdLevelName(SimdLevel level);
+const CompositeKernels &compositeKernels(SimdLevel level);
+
+// premultiplied ARGB8888 image, rows are width pixels apart
+struct SoftImage {
+    std::vector<Uint32> pixels;
+    int width = 0;
+    int height = 0;
+
+    void resize(int w, int h);
+    Uint32 *row(int y) { return pixels.data() + static_cast<std::size_t>(y) * width; }
+    const Uint32 *row(int y) const { return pixels.data() + static_cast<std::size_t>(y) * width; }
+};
+
+// Composites into a CPU frame instead of going through the renderer's blitters,
+// for the software renderer (no GPU) where every SDL blit is a generic per-pixel loop.
+class SoftCompositor {
+    SoftImage frame_;
+    SimdLevel level_;
+    const CompositeKernels *kernels_;
+
+public:
+    SoftCompositor(int width, int height, SimdLevel level = detectSimdLevel());
+
+    // unsupported levels fall back to SCALAR
+    void setSimdLevel(SimdLevel level);
+    SimdLevel simdLevel() const { return level_; }
+
+    SoftImage &frame() { return frame_; }
+    void resize(int width, int height) { frame_.resize(width, height); }
+
+    // all calls only touch the part of the frame inside area
+    void fill(const SDL_Rect &area, SDL_Color color);
+    // image with its top-left corner at (x, y)
+    void blendImage(const SoftImage &image, int x, int y, const SDL_Rect &area, Uint8 opacity = 255);
+    // rect of a straight-alpha color
+    void blendColor(const SDL_Rect &rect, const SDL_Rect &area, SDL_Color color, Uint8 opacity = 255);
+
+    // copies area of the frame into a streaming ARGB8888 texture of the frame size
+    void upload(SDL_Texture *texture, const SDL_Rect &area) const;
+};
+
+
+#endif // SOFT_COMPOSITOR_H
@@ -0,0 +1,34 @@
+#ifndef SPATIAL_GRID_H
+#define SPATIAL_GRID_H
+#include <vector>
+#include <unordered_map>
+
+#include <SDL2/SDL.h>
+
+class Widget;
+
+
+inline constexpr int DEFAULT_SPATIAL_CELL_SIZE = 64;
+
+// uniform grid over child rects, answers "which widgets may contain this point" in O(1)
+class SpatialGrid {
+    int cellSize_;
+    std::unordered_map<Uint64, std::vector<Widget *>> cells_;
+
+    static Uint64 cellKey(int cellX, int cellY);
+    int cellCord(int cord) const;
+
+public:
+    explicit SpatialGrid(int cellSize = DEFAULT_SPATIAL_CELL_SIZE);
+
+    void insert(Widget *widget, const SDL_Rect &rect);
+    void remove(Widget *widget, const SDL_Rect &rect);
+    void move(Widget *widget, const SDL_Rect &oldRect, const SDL_Rect &newRect);
+    void clear() { cells_.clear(); }
+
+    // widgets whose rect overlaps the cell of (x, y); nullptr when the cell is empty
+    const std::vector<Widget *> *candidates(int x, int y) const;
+};
+
+
+#endif // SPATIAL_GRID_H
@@ -0,0 +1,70 @@
+#ifndef TEXT_TEXTURE_CACHE_H
+#define TEXT_TEXTURE_CACHE_H
+#include <list>
+#include <string>
+#include <unordered_map>
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+
+
+inline constexpr std::size_t DEFAULT_TEXT_CACHE_BUDGET_BYTES = 32 * 1024 * 1024;
+
+struct TextTextureCacheStats {
+    std::size_t hits = 0;
+    std::size_t misses = 0;
+    std::size_t evictions = 0;
+    std::size_t bytes = 0;
+    std::size_t entries = 0;
+};
+
+// LRU cache of whole-string textures produced by createFontTexture, bounded by a VRAM byte budget
+class TextTextureCache {
+    struct Key {
+        TTF_Font *font;
+        std::string text;
+        Uint32 color;
+        bool operator==(const Key &other) const {
+            return font == other.font && color == other.color && text == other.text;
+        }
+    };
+
+    struct KeyHash {
+        std::size_t operator()(const Key &key) const;
+    };
+
+    struct Entry {
+        Key key;
+        SDL_Texture *texture;
+        SDL_Rect size;
+        std::size_t bytes;
+    };
+
+    SDL_Renderer *renderer_ = nullptr;
+    std::size_t budgetBytes_;
+
+    std::list<Entry> lru_; // front is the most recently used
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index_;
+    TextTextureCacheStats stats_{};
+
+    void evict(std::size_t incomingBytes);
+
+public:
+    explicit TextTextureCache(SDL_Renderer *renderer, std::size_t budgetBytes = DEFAULT_TEXT_CACHE_BUDGET_BYTES);
+    ~TextTextureCache();
+    TextTextureCache(const TextTextureCache &) = delete;
+    TextTextureCache &operator=(const TextTextureCache &) = delete;
+
+    // returned texture is owned by the cache and stays valid until the next get() or clear()
+    SDL_Texture *get(TTF_Font *font, const char text[], SDL_Color color, SDL_Rect *size = nullptr);
+
+    void setBudget(std::size_t budgetBytes);
+    std::size_t budget() const { return budgetBytes_; }
+    void clear();
+
+    const TextTextureCacheStats &stats() const { return stats_; }
+    void resetCounters();
+};
+
+
+#endif // TEXT_TEXTURE_CACHE_H
@@ -0,0 +1,51 @@
+#ifndef TEXTURE_POOL_H
+#define TEXTURE_POOL_H
+#include <vector>
+
+#include <SDL2/SDL.h>
+
+
+inline constexpr int TEXTURE_POOL_SIZE_STEP = 32;
+inline constexpr std::size_t DEFAULT_TEXTURE_POOL_BUDGET_BYTES = 64 * 1024 * 1024;
+
+struct TexturePoolStats {
+    std::size_t allocations = 0;
+    std::size_t reuses = 0;
+    std::size_t destroyed = 0;
+    std::size_t freeBytes = 0;
+    std::size_t freeTextures = 0;
+};
+
+// Render-target textures bucketed by size class (dimensions rounded up to TEXTURE_POOL_SIZE_STEP).
+// A texture handed out may be larger than requested: draw into and copy from {0, 0, w, h} only.
+class TexturePool {
+    struct FreeTexture {
+        SDL_Texture *texture;
+        int w, h;
+    };
+
+    SDL_Renderer *renderer_ = nullptr;
+    std::size_t budgetBytes_;
+    std::vector<FreeTexture> free_; // oldest released first
+    TexturePoolStats stats_{};
+
+    static int sizeClass(int size);
+    static std::size_t textureBytes(int w, int h) { return static_cast<std::size_t>(w) * h * 4; }
+
+public:
+    explicit TexturePool(SDL_Renderer *renderer, std::size_t budgetBytes = DEFAULT_TEXTURE_POOL_BUDGET_BYTES);
+    ~TexturePool();
+    TexturePool(const TexturePool &) = delete;
+    TexturePool &operator=(const TexturePool &) = delete;
+
+    SDL_Texture *acquire(int w, int h);
+    void release(SDL_Texture *texture);
+
+    // destroys the least recently released textures until the free ones fit into budgetBytes
+    void trim(std::size_t budgetBytes);
+    void setBudget(std::size_t budgetBytes);
+    const TexturePoolStats &stats() const { return stats_; }
+};
+
+
+#endif // TEXTURE_POOL_H
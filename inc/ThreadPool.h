@@ -0,0 +1,68 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
+
+
+// Work-stealing pool: every worker owns a deque, tasks submitted by a worker go to its own
+// deque and are taken LIFO, tasks from other threads go to a shared injection queue, idle
+// workers steal the oldest tasks of the others.
+class ThreadPool {
+    struct TaskQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    // one per worker, the last one is the injection queue
+    std::vector<std::unique_ptr<TaskQueue>> queues_;
+    std::vector<std::thread> workers_;
+    std::atomic<std::size_t> queued_{0};
+    std::atomic<bool> stopping_{false};
+    std::mutex sleepMutex_;
+    std::condition_variable cv_;
+
+    // index of the calling worker in this pool, queues_.size() - 1 for other threads
+    std::size_t currentIndex() const;
+    bool popBack(TaskQueue &queue, std::function<void()> &task);
+    bool popFront(TaskQueue &queue, std::function<void()> &task);
+    bool takeTask(std::size_t index, std::function<void()> &task);
+    void workerLoop(std::size_t index);
+
+public:
+    explicit ThreadPool(std::size_t threads = 0); // 0 = hardware concurrency
+    ~ThreadPool();
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    void submit(std::function<void()> task);
+    // runs one queued task on the calling thread, false if there was none
+    bool runPendingTask();
+    // finishes the queued tasks and joins the workers, submit() must not be called afterwards
+    void shutdown();
+    std::size_t size() const { return workers_.size(); }
+};
+
+// Tasks joined together; wait() runs queued tasks of the pool instead of blocking,
+// so groups may be nested inside tasks without starving the pool.
+class TaskGroup {
+    ThreadPool &pool_;
+    std::atomic<std::size_t> pending_{0};
+
+public:
+    explicit TaskGroup(ThreadPool &pool) : pool_(pool) {}
+    ~TaskGroup() { wait(); }
+    TaskGroup(const TaskGroup &) = delete;
+    TaskGroup &operator=(const TaskGroup &) = delete;
+
+    void run(std::function<void()> task);
+    void wait();
+};
+
+
+#endif // THREAD_POOL_H
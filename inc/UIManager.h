@@ -1,38 +1,142 @@
 #ifndef UI_MANAGER_H
 #define UI_MANAGER_H
 #include <vector>
+#include <memory>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
 #include <functional>
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_ttf.h>
 
 #include "Events.h"
+#include "DamageList.h"
+#include "PointerDispatcher.h"
+#include "GlyphAtlas.h"
+#include "TextTextureCache.h"
+#include "AssetManager.h"
+#include "TexturePool.h"
+#include "RenderState.h"
+#include "RenderBatch.h"
+#include "Animator.h"
+#include "Scheduler.h"
+#include "MpscQueue.h"
+#include "ThreadPool.h"
+#include "FramePacer.h"
+#include "SoftCompositor.h"
 class Widget;
 
 
 inline constexpr int DEFAULT_FRAME_DELAY_MS = 1000 / 60;
+// time allowed between the two strokes of a hotkey chord
+inline constexpr Uint32 DEFAULT_CHORD_TIMEOUT_MS = 1500;
+
+// stage durations of the last step()
+struct FrameTimings {
+    double eventsMs = 0;
+    double updateMs = 0;
+    double latchMs = 0;
+    double renderMs = 0;
+    double presentMs = 0;
+    bool presented = false;
+};
+
+// a closure to run or a widget to invalidate, posted from any thread
+struct PostedMessage {
+    std::function<void()> closure;
+    Widget *widget = nullptr;
+};
 
 struct UIManagerglobalState {
     Widget *hovered = nullptr;
     Widget *mouseActived = nullptr;
+    bool pointerCaptured = false; // mouseActived holds the pointer capture
+    Uint8 captureButton = SDL_BUTTON_LEFT; // its release ends the capture
+    Widget *focused = nullptr;
 };
 
 class UIManager {
     Widget *wTreeRoot_   = nullptr;
     std::vector<Widget*> modalWidgets_{};
     UIManagerglobalState glState_{};
+    PointerDispatcher pointerDispatcher_{};
     Uint32 frameDelayMs_;
+    bool eventDriven_ = false;
+    bool rawMouseMotion_ = false;
+    bool frameActive_ = true;
+    bool lateLatch_ = true;
+    bool latching_ = false;
+    FrameTimings frameTimings_{};
+    FramePacer pacer_;
 
     SDL_Renderer *renderer_ = nullptr;
     SDL_Window *mainWindow_ = nullptr;
+    std::unique_ptr<GlyphAtlas> glyphAtlas_;
+    std::unique_ptr<TextTextureCache> textTextureCache_;
+    std::unique_ptr<AssetManager> assetManager_;
+    std::unique_ptr<TexturePool> texturePool_;
+    std::unique_ptr<RenderState> renderState_;
+    std::unique_ptr<RenderBatch> renderBatch_;
+    std::unique_ptr<Animator> animator_;
+    std::unique_ptr<Scheduler> scheduler_;
+
+    // composed screen, only the damaged areas are recomposited each frame
+    SDL_Texture *frameTexture_ = nullptr;
+    DamageList screenDamage_;
+
+    // cross-thread messages, drained once per frame before the update pass
+    MpscQueue<PostedMessage> posted_;
+    std::vector<PostedMessage> postedBatch_; // reused between drains
+    std::vector<Widget *> postedInvalidations_;
+    std::atomic<bool> wakePending_{false};
+    Uint32 wakeEventType_ = (Uint32)-1;
+
+    // layers in blit order, grouped by the top-level widget (root or modal) they belong to
+    struct LayerEntry {
+        Widget *top;
+        Widget *layer;
+    };
+    std::vector<LayerEntry> layers_;
+    bool layersDirty_ = true;
+
+    // focusable widgets in Tab order, rebuilt when one is added, removed or reordered
+    std::vector<Widget *> focusChain_;
+    std::size_t focusIndex_ = 0; // of the focused widget, checked before use
+    bool focusChainDirty_ = true;
 
-    std::vector<std::function<void(int)>> userEvents_ = {};
+    // keyed by hotkeyCombo(), a chord by its first stroke and then its second
+    std::unordered_map<Uint64, std::function<void()>> hotkeys_;
+    std::unordered_map<Uint64, std::unordered_map<Uint64, std::function<void()>>> chords_;
+    Uint64 chordPrefix_ = 0; // first stroke of a chord in progress
+    Uint64 chordStartMs_ = 0;
+
+    // software compositing: tops (root, modals) and layers are mirrored as CPU images after
+    // they render, the damaged screen is blended on the CPU and uploaded into frameTexture_
+    struct SoftPlane {
+        SoftImage image;
+        bool valid = false;
+        bool solid = false; // solid leaf, only color is used
+        SDL_Color color{};
+        bool baked = false; // the opacity is part of the image (direct tops)
+        Uint8 bakedOpacity = 255;
+    };
+    std::unique_ptr<SoftCompositor> softCompositor_;
+    std::unordered_map<const Widget *, SoftPlane> softPlanes_;
+    SDL_Texture *softScratch_ = nullptr; // direct tops are composed here before the readback
+
+    // workers of Container::setIndependentChildren, created on first use; while a parallel
+    // update runs, writes leaving a subtree (parent damage, layers) go through treeMutex_
+    std::unique_ptr<ThreadPool> updatePool_;
+    // RasterWidget jobs, apart from updatePool_ so a join never waits behind a long raster
+    std::unique_ptr<ThreadPool> rasterPool_;
+    // the pools are first asked for from update tasks, which may run in parallel
+    std::once_flag updatePoolOnce_;
+    std::once_flag rasterPoolOnce_;
+    std::atomic<int> parallelUpdates_{0};
+    std::recursive_mutex treeMutex_;
 
 private:
     void globalStateOnMouseWheel(Widget *wgt, const MouseWheelEvent  &event);
-    void globalStateOnMouseMove (Widget *wgt, const MouseMotionEvent &event);
-    void globalStateOnMouseDown (Widget *wgt, const MouseButtonEvent &event);
-    void globalStateOnKeyDown   (Widget *wgt, const KeyEvent         &event);
-    void globalStateOnKeyUp     (Widget *wgt, const KeyEvent         &event);
 
     bool modalWidgetsOnMouseWheel(const MouseWheelEvent  &event);
     bool modalWidgetsOnMouseMove (const MouseMotionEvent &event);
@@ -41,11 +145,49 @@ private:
     bool modalWidgetsOnKeyUp     (const KeyEvent         &event);
     bool modalWidgetsOnMouseUp   (const MouseButtonEvent &event); 
 
+    bool runHotkey(const KeyEvent &event);
+    void dispatchKeyDown(const KeyEvent &event);
+    void dispatchKeyUp(const KeyEvent &event);
+    void focusChainChanged() { focusChainDirty_ = true; }
+    void rebuildFocusChain();
+    void collectFocusable(Widget *wgt);
+    bool focusReachable(const Widget *wgt) const;
+    // wgt belongs to a pushed modal instead of the main tree
+    bool focusInModal(const Widget *wgt) const;
+    void focusOnPress();
+
+    void dispatchMouseMove(const MouseMotionEvent &event);
+    gm_dot<int, 2> parentOrigin(const Widget *wgt) const;
+    Widget *capturedWidget();
+    void forgetWidget(const Widget *wgt);
+    bool rawMouseMotionWanted() const;
+    void foldMouseMotion(const SDL_MouseMotionEvent &sdlMotion, MouseMotionEvent &motion, bool &pending);
     void handleSDLEvents(bool *running);
+    bool latchPointer();
     void initWTree(Widget *wgt);
 
-    void updatePass();
+    void wake();
+    bool drainPosted();
+    bool updatePass();
     void renderPass();
+    bool needsPresent() const;
+    void compositeScreenArea(const SDL_Rect &area);
+    void layersChanged() { layersDirty_ = true; }
+    void rebuildLayers();
+    void collectLayers(Widget *top, Widget *wgt);
+    void compositeLayers(Widget *top, const SDL_Rect &area);
+    // hit path in composition order: the top's layers, topmost first, then its other content
+    void hitTestTop(Widget *top, const gm_dot<int, 2> &pos);
+    void renderPlane(Widget *wgt);
+    void refreshSoftPlane(Widget *wgt, SoftPlane &plane, const SDL_Rect &dirty);
+    void softCompositePlane(const Widget *wgt, const SDL_Rect &dst, const SDL_Rect &area);
+    void softCompositeScreenArea(const SDL_Rect &area);
+
+    ThreadPool &updatePool();
+    void enterParallelUpdate() { parallelUpdates_.fetch_add(1, std::memory_order_relaxed); }
+    void leaveParallelUpdate() { parallelUpdates_.fetch_sub(1, std::memory_order_relaxed); }
+    bool parallelUpdate() const { return parallelUpdates_.load(std::memory_order_relaxed) > 0; }
+    std::recursive_mutex &treeMutex() { return treeMutex_; }
 
 public: // user API
     UIManager(int width, int height, Uint32 frameDelay=DEFAULT_FRAME_DELAY_MS);
@@ -53,18 +195,100 @@ public: // user API
 
     void setMainWidget(int x, int y, Widget *mainWidget);
     void pushModalWidget(int x, int y, Widget *modalWidget);
+    // hotkeys run on key down before any widget sees the key; mods are KMOD_* flags matched
+    // exactly, either side counts (KMOD_LCTRL, KMOD_RCTRL and KMOD_CTRL are the same).
+    // Registering a combo again replaces its action.
     void registerHotkey(SDL_KeyCode hotkey, std::function<void()> action);
+    void registerHotkey(SDL_KeyCode hotkey, Uint16 mods, std::function<void()> action);
+    // two strokes, e.g. Ctrl+K then Ctrl+C, the second within DEFAULT_CHORD_TIMEOUT_MS
+    void registerHotkeyChord(SDL_KeyCode first, Uint16 firstMods, SDL_KeyCode second, Uint16 secondMods,
+                             std::function<void()> action);
+    void unregisterHotkey(SDL_KeyCode hotkey, Uint16 mods = KMOD_NONE);
 
     void run();
+    // one frame without pacing or waiting: events, update, render and present;
+    // returns false once quit was requested. For tests, benchmarks and external loops.
+    bool step();
+    const FrameTimings &frameTimings() const { return frameTimings_; }
+    // block until input/invalidation instead of rendering every frameDelay, present only dirty frames
+    void setEventDriven(bool eventDriven) { eventDriven_ = eventDriven; }
+    bool eventDriven() const { return eventDriven_; }
+    // deliver every motion sample instead of one coalesced event per batch
+    void setRawMouseMotion(bool raw) { rawMouseMotion_ = raw; }
+    // pointer motion that arrived during the update pass is dispatched right before rendering;
+    // handlers that defer their work to updateSelfAction should apply it at once while
+    // latchingPointer() is true, the update pass of this frame is over
+    void setLateLatch(bool lateLatch) { lateLatch_ = lateLatch; }
+    bool latchingPointer() const { return latching_; }
+    // present on vblank; returns false if the renderer cannot change it
+    bool setVSync(bool vsync);
+    bool vsync() const { return pacer_.vsync(); }
+    // measured time between the starts of the last two frames, for updateSelfAction
+    double frameDeltaMs() const { return pacer_.deltaMs(); }
+    // missed frames and worst intervals of run()
+    const FramePacingStats &framePacing() const { return pacer_.stats(); }
+    FramePacer &framePacer() { return pacer_; }
     const Widget *hovered() const { return glState_.hovered; }
     void setHovered(Widget *widget) { glState_.hovered = widget; }
     const Widget *mouseActived() const { return glState_.mouseActived; }
-    void setMouseActived(Widget *widget) { glState_.mouseActived = widget; }
+    void setMouseActived(Widget *widget);
+    // motion and the release of button go straight to widget until button is released, no hit
+    // testing and also outside of its rect; positions are in its parent's coordinates as usual.
+    // Other buttons are dispatched as usual meanwhile. The widget becomes mouse-actived.
+    void capturePointer(Widget *widget, Uint8 button = SDL_BUTTON_LEFT);
+    void releasePointer() { glState_.pointerCaptured = false; }
+    const Widget *pointerCapture() const { return glState_.pointerCaptured ? glState_.mouseActived : nullptr; }
+
+    // keys go to the focused widget and bubble up its parents; without focus they go to the
+    // modal widgets and the mouse-actived one. Tab and Shift+Tab not consumed on the way move
+    // the focus, a press focuses the innermost focusable widget under the pointer.
+    void setFocus(Widget *widget);
+    const Widget *focused() const { return glState_.focused; }
+    // next (or previous) visible focusable widget in Tab order, wraps around
+    bool focusNext(bool backward = false);
+
+    // blend the screen on the CPU with SIMD kernels instead of the renderer's blitters;
+    // meant for the software renderer, with a GPU renderer the readbacks cost more than they save
+    void setSoftwareCompositing(bool enabled, SimdLevel level = detectSimdLevel());
+    bool softwareCompositing() const { return softCompositor_ != nullptr; }
+
+    // rect is in screen coordinates, nullptr damages the whole screen
+    void damageScreen(const SDL_Rect *rect = nullptr);
+
+    // thread-safe: run closure on the UI thread at the start of the next frame
+    void post(std::function<void()> closure);
+    // thread-safe: invalidate the whole widget next frame, duplicates are coalesced;
+    // the widget must stay alive until then
+    void postInvalidate(Widget *widget);
 
-    void addUserEvent(std::function<void(int)> userEvent) { userEvents_.push_back(userEvent); };
+    // runs userEvent every frame delay with the real elapsed milliseconds, kept for old callers
+    TimerHandle addUserEvent(std::function<void(int)> userEvent);
     TTF_Font* createFont(const char fontPath[], const size_t fontSize);
+    // batched text drawing from cached glyphs, prefer it over createFontTexture for changing text
+    GlyphAtlas &glyphAtlas() { return *glyphAtlas_; }
+    // whole-string text textures for complex scripts/effects, repeated strings cost one lookup
+    TextTextureCache &textTextureCache() { return *textTextureCache_; }
+    // shared images decoded off-thread, uploaded by step() after the update pass within
+    // DEFAULT_ASSET_UPLOAD_BUDGET_MS
+    AssetManager &assets() { return *assetManager_; }
+    // widget render targets, hidden and destroyed widgets return theirs for reuse
+    TexturePool &texturePool() { return *texturePool_; }
+    // workers of the RasterWidgets, created on first use; thread-safe
+    ThreadPool &rasterPool();
+    // shadowed renderer state of the render pass, code drawing outside of renderSelfAction
+    // between frames is fine, the pass starts with forget()
+    RenderState &renderState() { return *renderState_; }
+    // shared by the containers while they composite their children
+    RenderBatch &renderBatch() { return *renderBatch_; }
+    // position and opacity tweens, keeps the loop active while running
+    Animator &animator() { return *animator_; }
+    // timers run at the start of the frame and in the update pass, delays count from the
+    // frame's start; an event-driven loop sleeps until the next one is due
+    // (not thread-safe, like animator(): parallel updates must post() instead)
+    Scheduler &scheduler() { return *scheduler_; }
 
 friend class Widget;
+friend class Container;
 };
 
 
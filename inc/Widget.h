@@ -4,37 +4,110 @@
 
 #include <SDL2/SDL.h>
 #include "Common.h"
+#include "DamageList.h"
 
 class UIManager;
+class RenderBatch;
 class MouseButtonEvent;
 class MouseWheelEvent;
 class MouseMotionEvent;
 class KeyEvent;
 
+// DIRECT widgets draw straight into the target of their nearest cached ancestor (or the screen)
+// through a translated viewport and clip rect; CACHED widgets keep their own texture.
+enum class CompositionPolicy {
+    DIRECT,
+    CACHED
+};
+
 class Widget {  
+    // held while a parallel update leaves the subtree, defined in Widget.cpp
+    class TreeLock;
+
 protected:
     UIManager *UIManager_ = nullptr;
     Widget *parent_ = nullptr;
 
     Rect rect_;
     SDL_Texture* texture_ = nullptr;
+    DamageList damage_;
 
+    CompositionPolicy composition_ = CompositionPolicy::DIRECT;
+    // compositor properties, changing them only touches the final blit
+    bool layer_ = false;
+    Uint8 opacity_ = 255;
+    int zOrder_ = 0;
+    bool opaque_ = false;
+    bool wantsUpdate_ = false;
+    bool inTickList_ = false; // member of the parent's tick list
     bool needRerender_ = true;
     bool isHiden_ = false; 
+    bool rawMouseMotion_ = false;
+    bool solidFill_ = false; // see setSolidFill
+    bool focusable_ = false;
+    int tabIndex_ = 0;
+
+    // position in parent's children list, 0 is the topmost
+    std::size_t siblingIndex_ = 0;
 
     void setParentImpl(Widget* child, Widget* parent) { child->parent_ = parent; }
+    void setSiblingIndexImpl(Widget* child, std::size_t index) { child->siblingIndex_ = index; }
+    void attachUIManagerImpl(Widget* wgt, UIManager *manager) { wgt->attachUIManager(manager); }
+    // child changed its place in the children list
+    void restackImpl(Widget* child);
+    void setInTickListImpl(Widget* child, bool inList) { child->inTickList_ = inList; }
+    bool inTickListImpl(const Widget* child) const { return child->inTickList_; }
+    void damageParent(const SDL_Rect &rect);
+
+    // render target comes from the UIManager texture pool and may be larger than rect_
+    void acquireTexture(SDL_Renderer* renderer);
+    void releaseTexture();
+    // a hidden widget returns the targets of its whole subtree to the pool
+    void releaseSubtreeTextures();
+    void attachUIManager(UIManager *manager);
+    bool keepsTexture() const;
+    void finishDirectRender();
+    // solid fill or renderSelfAction into the current target, dst and clip are in target coordinates
+    void composeSelf(SDL_Renderer* renderer, RenderBatch &batch, const SDL_Rect &dst, const SDL_Rect &clip);
+
+    virtual void childRectChanged(Widget *child, const Rect &oldRect) {}
+    // child or one of its descendants started wanting updates
+    virtual void childWantsUpdate(Widget *child) {}
+    void enlistForUpdate() { if (parent_) parent_->childWantsUpdate(this); }
+    // update may be running on a worker thread: no SDL calls, UI thread work goes through post()
+    bool inParallelUpdate() const;
 
 public:
     Widget(int width, int height, Widget *parent = nullptr);
     virtual ~Widget();
 
     virtual void renderSelfAction(SDL_Renderer* renderer);
+    // true if renderSelfAction is a plain fill of the whole rect; such leaves need no texture
+    // and are drawn by the parent as one geometry batch. Only after setSolidFill(true).
+    virtual bool solidColor(SDL_Color &color) const;
+    // declares that the widget draws nothing but the default fill of its class (white for
+    // Widget), so renderSelfAction can be skipped; subclasses drawing more must not set it
+    void setSolidFill(bool solidFill);
+    bool solidFill() const { return solidFill_; }
+    bool isSolidLeaf(SDL_Color &color) const { return getChildren().empty() && solidColor(color); }
+    // brings the textures of cached widgets in the subtree up to date
     virtual bool render(SDL_Renderer* renderer);
+    // draws the widget into the current target at dst; clip is the renderer clip rect
+    // set by the caller and is restored before returning
+    virtual void composeInto(SDL_Renderer* renderer, RenderBatch &batch, const SDL_Rect &dst, const SDL_Rect &clip);
+    // called by the parent only while needsUpdate(), returns true if something changed;
+    // may run on a worker thread under a container with independent children
     virtual bool update();
     virtual bool updateSelfAction();
+    // updateSelfAction runs only for widgets that opted in, subtrees without such widgets are skipped
+    void setWantsUpdate(bool wants);
+    bool wantsUpdate() const { return wantsUpdate_; }
+    virtual bool needsUpdate() const { return wantsUpdate_; }
 
     // Events: return false to stop propagation (CONSUME), true to continue (PROPAGATE)
-    // propagation logic
+    // propagation logic; deprecated for the pointer: UIManager dispatches mouse down, up and move
+    // through PointerDispatcher (capture hooks, then self actions) and never calls these,
+    // overriding them has no effect there
     virtual bool onMouseDown(const MouseButtonEvent &event);
     virtual bool onMouseUp(const MouseButtonEvent &event);
     virtual bool onMouseWheel(const MouseWheelEvent &event);
@@ -49,24 +122,74 @@ public:
     virtual bool onMouseMoveSelfAction(const MouseMotionEvent &event);
     virtual bool onKeyDownSelfAction(const KeyEvent &event);
     virtual bool onKeyUpSelfAction(const KeyEvent &event);
+    virtual void onFocusSelfAction(bool focused);
+
+    // capture phase of the fused pointer dispatch, runs root -> leaf before the self actions
+    virtual bool onMouseDownCapture(const MouseButtonEvent &event);
+    virtual bool onMouseUpCapture(const MouseButtonEvent &event);
+    virtual bool onMouseMoveCapture(const MouseMotionEvent &event);
 
     // Getters / Setters
+    // direct widgets must not call SDL_RenderClear or switch the render target in renderSelfAction
+    void setCompositionPolicy(CompositionPolicy policy);
+    CompositionPolicy compositionPolicy() const { return composition_; }
+    void setCacheLayer(bool cached) { setCompositionPolicy(cached ? CompositionPolicy::CACHED : CompositionPolicy::DIRECT); }
+    bool isCacheLayer() const { return composition_ == CompositionPolicy::CACHED; }
+
+    // Layers keep their own texture and are blitted by the UIManager above their top-level widget
+    // instead of being baked into the parent, so moving, fading or restacking one only damages
+    // its old and new screen rects. Opacity is honoured by layers, cached and solid widgets.
+    void setLayer(bool layer);
+    bool isLayer() const { return layer_; }
+    void setOpacity(Uint8 opacity);
+    Uint8 opacity() const { return opacity_; }
+    // layers of one top-level widget are stacked by z-order, then by paint order
+    void setZOrder(int zOrder);
+    int zOrder() const { return zOrder_; }
+    // screen rect and the visible part of it after clipping by the ancestors,
+    // false if an ancestor is hidden or nothing is visible
+    bool screenPlacement(SDL_Rect &dst, SDL_Rect &clip) const;
+
+    // declares that renderSelfAction covers the whole rect with opaque pixels, so the parent
+    // can skip the siblings and the parts of itself underneath; solid colors are detected
+    void setOpaque(bool opaque);
+    bool isOpaque() const;
+
     bool isHiden() const { return isHiden_; }
-    void hide() { isHiden_ = true; }
-    void show() { isHiden_ = false; }
+    void hide();
+    void show();
+    // while hovered or mouse-actived the widget receives every motion sample, not coalesced ones
+    bool rawMouseMotion() const { return rawMouseMotion_; }
+    void setRawMouseMotion(bool raw) { rawMouseMotion_ = raw; }
+    // focusable widgets get the keyboard by a press or by Tab/Shift+Tab, see UIManager::setFocus
+    void setFocusable(bool focusable);
+    bool isFocusable() const { return focusable_; }
+    // Tab order: lower tab index first, then tree order
+    void setTabIndex(int tabIndex);
+    int tabIndex() const { return tabIndex_; }
+    bool hasFocus() const;
     
     virtual const std::vector<Widget *> &getChildren() const;
-    void setPosition(int x, int y) { rect_.x = x; rect_.y = y; }
-    void setSize(int w, int h) { rect_.w = w; rect_.h = h; }
-    void setRerenderFlag() { 
-        needRerender_ = true;
-        if (parent_) parent_->invalidate();
-    }   
-    void invalidate() { needRerender_ = true; }
+    // topmost visible child containing (x, y) given in this widget's children coordinates
+    virtual Widget *childAt(int x, int y) const { return nullptr; }
+    // next visible child containing (x, y) below the child above
+    virtual Widget *childBelowAt(const Widget *above, int x, int y) const { return nullptr; }
+    std::size_t siblingIndex() const { return siblingIndex_; }
+    void setPosition(int x, int y);
+    void setSize(int w, int h);
+
+    // rect is in local coordinates, nullptr damages the whole widget;
+    // damage is propagated to the parents and to the screen
+    void invalidate(const SDL_Rect *rect = nullptr);
+    void setRerenderFlag(const SDL_Rect *rect = nullptr) { invalidate(rect); }
     bool needRerender() const { return needRerender_; }
+    const DamageList &damage() const { return damage_; }
     Rect rect() const;
     const Widget *parent() const;
+    Widget *parent();
     SDL_Texture* texture();
+    // part of texture() holding the widget image
+    SDL_Rect textureRect() const { return {0, 0, rect_.w, rect_.h}; }
 
     friend class UIManager;
 };
@@ -10,9 +10,15 @@ protected:
     gm_dot<int, 2> accumulatedRel_ = {0, 0};
     bool replaced_ = true;
 public:
-    Window(int w, int h, Widget *parent=nullptr) : Container(w, h, parent) {}    
+    // not a layer by default: a layer is stacked above all the non-layer content of its
+    // top-level widget, whatever its sibling order. setLayer(true) makes a drag only move it.
+    // updates are wanted only while a drag is pending
+    Window(int w, int h, Widget *parent=nullptr) : Container(w, h, parent) { wantsUpdate_ = replaced_; }
 
     void renderSelfAction(SDL_Renderer* renderer) override;
+    bool solidColor(SDL_Color &color) const override;
+    // a press on the window itself (not on a child) captures the pointer for the drag
+    bool onMouseDownSelfAction(const MouseButtonEvent &event) override;
     bool onMouseMoveSelfAction(const MouseMotionEvent &event) override;
     bool updateSelfAction() override;
 };
@@ -0,0 +1,89 @@
+#include <cassert>
+#include <cmath>
+#include <algorithm>
+
+#include "Animator.h"
+#include "Widget.h"
+
+float Animator::ease(Easing easing, float t) {
+    switch (easing) {
+        case Easing::EASE_IN:     return t * t * t;
+        case Easing::EASE_OUT:    return 1.f - (1.f - t) * (1.f - t) * (1.f - t);
+        case Easing::EASE_IN_OUT: return t < 0.5f ? 4.f * t * t * t : 1.f - std::pow(-2.f * t + 2.f, 3.f) / 2.f;
+        default:                  return t;
+    }
+}
+
+float Animator::currentValue(const Widget *widget, AnimatedProperty property) {
+    switch (property) {
+        case AnimatedProperty::X:       return static_cast<float>(widget->rect().x);
+        case AnimatedProperty::Y:       return static_cast<float>(widget->rect().y);
+        case AnimatedProperty::OPACITY: return static_cast<float>(widget->opacity());
+    }
+    return 0.f;
+}
+
+void Animator::apply(Widget *widget, AnimatedProperty property, float value) {
+    int rounded = static_cast<int>(std::lround(value));
+    Rect rect = widget->rect();
+
+    switch (property) {
+        case AnimatedProperty::X:       widget->setPosition(rounded, rect.y); break;
+        case AnimatedProperty::Y:       widget->setPosition(rect.x, rounded); break;
+        case AnimatedProperty::OPACITY: widget->setOpacity(static_cast<Uint8>(std::clamp(rounded, 0, 255))); break;
+    }
+}
+
+void Animator::animate(Widget *widget, AnimatedProperty property, float to, Uint32 durationMs,
+                       Easing easing, std::function<void()> onFinished) {
+    assert(widget);
+
+    tracks_.erase(std::remove_if(tracks_.begin(), tracks_.end(), [&](const Track &track) {
+        return track.widget == widget && track.property == property;
+    }), tracks_.end());
+
+    tracks_.push_back({widget, property, currentValue(widget, property), to,
+                       SDL_GetTicks(), durationMs, easing, std::move(onFinished)});
+}
+
+void Animator::moveTo(Widget *widget, int x, int y, Uint32 durationMs, Easing easing) {
+    animate(widget, AnimatedProperty::X, static_cast<float>(x), durationMs, easing);
+    animate(widget, AnimatedProperty::Y, static_cast<float>(y), durationMs, easing);
+}
+
+void Animator::fadeTo(Widget *widget, Uint8 opacity, Uint32 durationMs, Easing easing,
+                      std::function<void()> onFinished) {
+    animate(widget, AnimatedProperty::OPACITY, static_cast<float>(opacity), durationMs, easing, std::move(onFinished));
+}
+
+void Animator::cancel(Widget *widget) {
+    tracks_.erase(std::remove_if(tracks_.begin(), tracks_.end(), [&](const Track &track) {
+        return track.widget == widget;
+    }), tracks_.end());
+}
+
+bool Animator::update(Uint32 nowMs) {
+    if (tracks_.empty()) return false;
+
+    // callbacks may start new animations, they run after the tracks are updated
+    std::vector<std::function<void()>> finished;
+
+    for (std::size_t i = 0; i < tracks_.size(); ) {
+        Track &track = tracks_[i];
+        Uint32 elapsed = nowMs - track.startMs;
+        float t = track.durationMs ? std::min(1.f, static_cast<float>(elapsed) / track.durationMs) : 1.f;
+
+        apply(track.widget, track.property, track.from + (track.to - track.from) * ease(track.easing, t));
+
+        if (t < 1.f) {
+            i++;
+            continue;
+        }
+
+        if (track.onFinished) finished.push_back(std::move(track.onFinished));
+        tracks_.erase(tracks_.begin() + i);
+    }
+
+    for (auto &callback : finished) callback();
+    return true;
+}
@@ -0,0 +1,194 @@
+#include <cassert>
+#include <iostream>
+#include <SDL_image.h>
+
+#include "AssetManager.h"
+#include "Profiler.h"
+
+ImageHandle::ImageHandle(AssetManager *manager, ImageAsset *asset)
+    : manager_(manager), asset_(asset)
+{
+    if (asset_) manager_->acquire(asset_);
+}
+
+ImageHandle::ImageHandle(const ImageHandle &other)
+    : ImageHandle(other.manager_, other.asset_) {}
+
+ImageHandle::ImageHandle(ImageHandle &&other) noexcept
+    : manager_(other.manager_), asset_(other.asset_)
+{
+    other.manager_ = nullptr;
+    other.asset_ = nullptr;
+}
+
+ImageHandle &ImageHandle::operator=(ImageHandle other) {
+    std::swap(manager_, other.manager_);
+    std::swap(asset_, other.asset_);
+    return *this;
+}
+
+ImageHandle::~ImageHandle() {
+    reset();
+}
+
+void ImageHandle::reset() {
+    if (asset_) manager_->release(asset_);
+    manager_ = nullptr;
+    asset_ = nullptr;
+}
+
+SDL_Texture *ImageHandle::texture() const {
+    if (!asset_) return nullptr;
+    if (asset_->texture) return asset_->texture;
+    return manager_->placeholder();
+}
+
+bool ImageHandle::ready() const {
+    return asset_ && asset_->state == AssetState::READY;
+}
+
+bool ImageHandle::failed() const {
+    return asset_ && asset_->state == AssetState::FAILED;
+}
+
+void ImageHandle::onReady(std::function<void()> callback) const {
+    if (!asset_) return;
+
+    if (ready()) callback();
+    else asset_->onReady.push_back(std::move(callback));
+}
+
+
+AssetManager::AssetManager(SDL_Renderer *renderer, std::size_t workers)
+    : renderer_(renderer), workers_(workers)
+{
+    assert(renderer_);
+
+    // 2x2 grey checker shown until the real image is uploaded
+    const Uint32 checker[4] = {0xA0A0A0FF, 0x707070FF, 0x707070FF, 0xA0A0A0FF};
+    placeholder_ = SDL_CreateTexture(renderer_, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STATIC, 2, 2);
+    assert(placeholder_);
+    SDL_UpdateTexture(placeholder_, nullptr, checker, 2 * sizeof(Uint32));
+    SDL_SetTextureBlendMode(placeholder_, SDL_BLENDMODE_BLEND);
+
+    wakeEventType_ = SDL_RegisterEvents(1);
+}
+
+AssetManager::~AssetManager() {
+    workers_.shutdown();
+
+    for (auto &entry : assets_) {
+        ImageAsset *asset = entry.second.get();
+        if (asset->surface) SDL_FreeSurface(asset->surface);
+        if (asset->texture) SDL_DestroyTexture(asset->texture);
+    }
+    assets_.clear();
+
+    if (placeholder_) SDL_DestroyTexture(placeholder_);
+}
+
+ImageHandle AssetManager::loadImage(const char *path) {
+    assert(path);
+
+    auto found = assets_.find(path);
+    if (found != assets_.end()) return ImageHandle(this, found->second.get());
+
+    std::unique_ptr<ImageAsset> asset = std::make_unique<ImageAsset>();
+    asset->path = path;
+    ImageAsset *raw = asset.get();
+    assets_.emplace(raw->path, std::move(asset));
+
+    workers_.submit([this, raw] { decode(raw); });
+    return ImageHandle(this, raw);
+}
+
+void AssetManager::decode(ImageAsset *asset) {
+    MYGUI_PROFILE_SCOPE("decodeImage");
+    SDL_Surface *surface = IMG_Load(asset->path.c_str());
+    if (!surface) {
+        std::cerr << "Texture load failed : " << asset->path << "\n";
+    }
+
+    asset->surface = surface;
+    asset->state = surface ? AssetState::DECODED : AssetState::FAILED;
+
+    {
+        std::lock_guard<std::mutex> lock(decodedMutex_);
+        decoded_.push_back(asset);
+    }
+
+    // wake a main loop blocked in SDL_WaitEvent
+    if (wakeEventType_ != (Uint32)-1) {
+        SDL_Event wake = {};
+        wake.type = wakeEventType_;
+        SDL_PushEvent(&wake);
+    }
+}
+
+bool AssetManager::hasPendingUploads() {
+    if (!uploadQueue_.empty()) return true;
+
+    std::lock_guard<std::mutex> lock(decodedMutex_);
+    return !decoded_.empty();
+}
+
+std::size_t AssetManager::uploadPending(Uint32 budgetMs) {
+    {
+        std::lock_guard<std::mutex> lock(decodedMutex_);
+        uploadQueue_.insert(uploadQueue_.end(), decoded_.begin(), decoded_.end());
+        decoded_.clear();
+    }
+    if (uploadQueue_.empty()) return 0;
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    Uint64 budget = SDL_GetPerformanceFrequency() * budgetMs / 1000;
+
+    std::size_t processed = 0;
+    std::size_t uploaded = 0;
+    while (processed < uploadQueue_.size()) {
+        // at least one image per frame so a tiny budget can not starve the queue
+        if (uploaded > 0 && SDL_GetPerformanceCounter() - start > budget) break;
+
+        ImageAsset *asset = uploadQueue_[processed++];
+        asset->settled = true;
+        if (asset->refCount == 0) {
+            destroy(asset); // every handle was dropped while decoding
+            continue;
+        }
+        if (asset->state == AssetState::FAILED) continue;
+
+        asset->texture = SDL_CreateTextureFromSurface(renderer_, asset->surface);
+        SDL_FreeSurface(asset->surface);
+        asset->surface = nullptr;
+
+        if (!asset->texture) {
+            SDL_Log("SDL_CreateTextureFromSurface failed: %s", SDL_GetError());
+            asset->state = AssetState::FAILED;
+            continue;
+        }
+        SDL_SetTextureBlendMode(asset->texture, SDL_BLENDMODE_BLEND);
+        asset->state = AssetState::READY;
+        uploaded++;
+
+        std::vector<std::function<void()>> callbacks;
+        callbacks.swap(asset->onReady);
+        for (std::function<void()> &callback : callbacks) callback();
+    }
+
+    uploadQueue_.erase(uploadQueue_.begin(), uploadQueue_.begin() + processed);
+    return uploaded;
+}
+
+void AssetManager::release(ImageAsset *asset) {
+    assert(asset->refCount > 0);
+    if (--asset->refCount > 0) return;
+
+    // an unsettled asset is still referenced by a worker or the upload queue, uploadPending drops it later
+    if (asset->settled) destroy(asset);
+}
+
+void AssetManager::destroy(ImageAsset *asset) {
+    if (asset->surface) SDL_FreeSurface(asset->surface);
+    if (asset->texture) SDL_DestroyTexture(asset->texture);
+    assets_.erase(asset->path);
+}
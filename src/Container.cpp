@@ -1,5 +1,11 @@
+#include <algorithm>
+
 #include "Container.h"
 #include "Events.h"
+#include "RenderBatch.h"
+#include "UIManager.h"
+#include "ThreadPool.h"
+#include "Profiler.h"
 
 Container::Container(int width, int height, Widget *parent)
     : Widget(width, height, parent) {}
@@ -9,17 +15,69 @@ Container::~Container() {
     children_.clear();
 }
 
+template <typename Visitor>
+bool Container::visitChildrenAt(int x, int y, Visitor visit) {
+    for (Widget *child = childAt(x, y); child; child = childBelowAt(child, x, y)) {
+        if (visit(child) == CONSUME) return CONSUME;
+    }
+    return PROPAGATE;
+}
+
+Widget *Container::childAtFrom(int x, int y, std::size_t first) const {
+    if (!spatialIndex_) {
+        for (std::size_t i = first; i < children_.size(); i++) {
+            if (!children_[i]->isHiden() && isInsideRect(children_[i]->rect(), x, y)) return children_[i];
+        }
+        return nullptr;
+    }
+
+    const std::vector<Widget *> *candidates = spatialIndex_->candidates(x, y);
+    if (!candidates) return nullptr;
+
+    // lowest sibling index in place, no sorting
+    Widget *top = nullptr;
+    for (Widget *child : *candidates) {
+        if (child->siblingIndex() < first || child->isHiden()) continue;
+        if (top && top->siblingIndex() < child->siblingIndex()) continue;
+        if (isInsideRect(child->rect(), x, y)) top = child;
+    }
+    return top;
+}
+
+Widget *Container::childAt(int x, int y) const {
+    return childAtFrom(x, y, 0);
+}
+
+Widget *Container::childBelowAt(const Widget *above, int x, int y) const {
+    return childAtFrom(x, y, above->siblingIndex() + 1);
+}
+
+void Container::childRectChanged(Widget *child, const Rect &oldRect) {
+    if (!spatialIndex_) return;
+
+    // addWidget positions the child before it is inserted into children_ and the index
+    std::size_t idx = child->siblingIndex();
+    if (idx >= children_.size() || children_[idx] != child) return;
+
+    spatialIndex_->move(child, oldRect, child->rect());
+}
+
+void Container::enableSpatialIndex(int cellSize) {
+    spatialIndex_ = std::make_unique<SpatialGrid>(cellSize);
+    for (Widget *child : children_) spatialIndex_->insert(child, child->rect());
+}
+
 bool Container::onMouseDown(const MouseButtonEvent &event) {
     if (!isInsideRect(rect_, event.pos.x, event.pos.y)) return PROPAGATE; 
 
-    for (Widget *child : children_) {
-        MouseButtonEvent childLocal = event;
+    MouseButtonEvent childLocal = event;
+    childLocal.pos.x -= rect_.x;
+    childLocal.pos.y -= rect_.y;
 
-        childLocal.pos.x -= rect_.x;
-        childLocal.pos.y -= rect_.y;
-    
-        if (child->onMouseDown(childLocal) == CONSUME) return CONSUME; // stop propagation
-    }
+    bool propagation = visitChildrenAt(childLocal.pos.x, childLocal.pos.y, [&childLocal](Widget *child) {
+        return child->onMouseDown(childLocal);
+    });
+    if (propagation == CONSUME) return CONSUME; // stop propagation
 
     if (onMouseDownSelfAction(event) == CONSUME) return CONSUME;
 
@@ -27,15 +85,16 @@ bool Container::onMouseDown(const MouseButtonEvent &event) {
 }
 
 bool Container::onMouseUp(const MouseButtonEvent &event) {
-    if (!isInsideRect(rect_, event.pos.x, event.pos.y)) return PROPAGATE;
+    if (!isInsideRect(rect_, event.pos.x, event.pos.y)) return PROPAGATE; 
 
-    for (Widget *child : children_) {
-        MouseButtonEvent childLocal = event;
-        childLocal.pos.x -= rect_.x;
-        childLocal.pos.y -= rect_.y;
-    
-        if (child->onMouseUp(childLocal) == CONSUME) return CONSUME;
-    }
+    MouseButtonEvent childLocal = event;
+    childLocal.pos.x -= rect_.x;
+    childLocal.pos.y -= rect_.y;
+
+    bool propagation = visitChildrenAt(childLocal.pos.x, childLocal.pos.y, [&childLocal](Widget *child) {
+        return child->onMouseUp(childLocal);
+    });
+    if (propagation == CONSUME) return CONSUME; // stop propagation
 
     if (onMouseUpSelfAction(event) == CONSUME) return CONSUME;
 
@@ -43,96 +102,234 @@ bool Container::onMouseUp(const MouseButtonEvent &event) {
 }
 
 bool Container::onMouseMove(const MouseMotionEvent &event) {
-    if (!isInsideRect(rect_, event.pos.x, event.pos.y)) return PROPAGATE;
-    
-    for (Widget *child : children_) {
-        MouseMotionEvent childLocal = event;
-        childLocal.pos.x -= rect_.x;
-        childLocal.pos.y -= rect_.y;
+    if (!isInsideRect(rect_, event.pos.x, event.pos.y)) return PROPAGATE; 
 
-        if (child->onMouseMove(childLocal) == CONSUME) return CONSUME;
-    }
+    MouseMotionEvent childLocal = event;
+    childLocal.pos.x -= rect_.x;
+    childLocal.pos.y -= rect_.y;
+
+    bool propagation = visitChildrenAt(childLocal.pos.x, childLocal.pos.y, [&childLocal](Widget *child) {
+        return child->onMouseMove(childLocal);
+    });
+    if (propagation == CONSUME) return CONSUME; // stop propagation
 
     if (onMouseMoveSelfAction(event) == CONSUME) return CONSUME;
     
     return PROPAGATE;
 }
 
-void reorderWidgets(std::vector<std::pair<bool, Widget *>> &reorderingBufer) {
-    int left = 0;
-    int right = (int)(reorderingBufer.size()) - 1;
-    while (right - left > 0) {
-        if (!reorderingBufer[left].first && reorderingBufer[right].first) {
-            std::swap(reorderingBufer[left], reorderingBufer[right]);
-        }
-        if (reorderingBufer[left].first) {
-            left++;
+void Container::childWantsUpdate(Widget *child) {
+    if (inTickListImpl(child)) return;
+
+    setInTickListImpl(child, true);
+    tickList_.push_back(child);
+    enlistForUpdate();
+}
+
+void Container::raiseUpdatedChildren(std::size_t count) {
+    std::sort(tickList_.begin(), tickList_.begin() + count, [](const Widget *a, const Widget *b) {
+        return a->siblingIndex() < b->siblingIndex();
+    });
+
+    // sibling indices still hold the old slots, a rotation never moves the entries after it
+    std::size_t front = 0;
+    for (std::size_t i = 0; i < count; i++, front++) {
+        std::size_t idx = tickList_[i]->siblingIndex();
+        if (idx != front) std::rotate(children_.begin() + front, children_.begin() + idx, children_.begin() + idx + 1);
+    }
+
+    std::size_t last = tickList_[count - 1]->siblingIndex();
+    for (std::size_t i = 0; i <= last; i++) {
+        if (children_[i]->siblingIndex() == i) continue;
+
+        // z-order changed, the child has to be recomposited
+        setSiblingIndexImpl(children_[i], i);
+        restackImpl(children_[i]);
+    }
+}
+
+void Container::updateChildrenParallel(std::size_t count) {
+    tickResults_.assign(count, 0);
+
+    UIManager_->enterParallelUpdate();
+    {
+        TaskGroup group(UIManager_->updatePool());
+        for (std::size_t i = 0; i < count; i++) {
+            Widget *child = tickList_[i];
+            char *result = &tickResults_[i];
+            group.run([child, result] { *result = child->needsUpdate() && child->update(); });
         }
-        if (!reorderingBufer[right].first) {
-            right--;
+    } // joined here
+    UIManager_->leaveParallelUpdate();
+}
+
+bool Container::update() {
+    MYGUI_PROFILE_WIDGET_SCOPE("update", this);
+    bool updated = wantsUpdate_ && updateSelfAction();
+
+    std::size_t ticked = 0;
+    if (independentChildren_ && UIManager_ && tickList_.size() > 1) {
+        ticked = tickList_.size();
+        updateChildrenParallel(ticked);
+    }
+
+    // compacted in place: updated children first, then the ones still ticking;
+    // children enlisted meanwhile are appended and ticked in this pass too
+    std::size_t updatedCount = 0, kept = 0;
+    for (std::size_t i = 0; i < tickList_.size(); i++) {
+        Widget *child = tickList_[i];
+        bool childUpdated = i < ticked ? tickResults_[i] != 0 : child->needsUpdate() && child->update();
+
+        if (!childUpdated && !child->needsUpdate()) {
+            setInTickListImpl(child, false);
+            continue;
         }
+
+        tickList_[kept] = child;
+        if (childUpdated) std::swap(tickList_[kept], tickList_[updatedCount++]);
+        kept++;
     }
+    tickList_.resize(kept);
+
+    // updated children are moved to the front (top) of the z-order
+    if (updatedCount) {
+        raiseUpdatedChildren(updatedCount);
+        updated = true;
+    }
+
+    return updated;
 }
 
-bool Container::update() {
-    bool updated = updateSelfAction();
+static bool rectContains(const SDL_Rect &outer, const SDL_Rect &inner) {
+    return inner.x >= outer.x && inner.y >= outer.y &&
+           inner.x + inner.w <= outer.x + outer.w && inner.y + inner.h <= outer.y + outer.h;
+}
 
-    std::vector<std::pair<bool, Widget *>> reorderingBufer(children_.size());
+static int rectArea(const SDL_Rect &rect) { return rect.w * rect.h; }
 
-    for (std::size_t i = 0; i < children_.size(); i++) {
+bool Container::cullChildren(int originX, int originY, const SDL_Rect &bounds) {
+    culled_.assign(children_.size(), 1);
+
+    SDL_Rect occluders[MAX_OCCLUDERS];
+    std::size_t occludersCount = 0;
+    bool covered = false;
+
+    // front to back, children_[0] is the topmost
+    for (std::size_t i = 0; i < children_.size() && !covered; i++) {
         Widget *child = children_[i];
-        bool childUpdated = child->update();
-        reorderingBufer[i] = {childUpdated, child};
-        updated |= childUpdated;
+        if (child->isHiden() || child->isLayer()) continue; // layers are blitted by the UIManager
+
+        SDL_Rect visible = child->rect();
+        visible.x += originX;
+        visible.y += originY;
+        if (!SDL_IntersectRect(&visible, &bounds, &visible)) continue;
+
+        bool occluded = false;
+        for (std::size_t j = 0; j < occludersCount && !occluded; j++) occluded = rectContains(occluders[j], visible);
+        if (occluded) continue;
+
+        culled_[i] = 0;
+        if (!child->isOpaque()) continue;
+
+        covered = SDL_RectEquals(&visible, &bounds);
+        if (occludersCount < MAX_OCCLUDERS) {
+            occluders[occludersCount++] = visible;
+            continue;
+        }
+
+        SDL_Rect *smallest = std::min_element(occluders, occluders + MAX_OCCLUDERS,
+            [](const SDL_Rect &a, const SDL_Rect &b) { return rectArea(a) < rectArea(b); });
+        if (rectArea(*smallest) < rectArea(visible)) *smallest = visible;
     }
 
-    reorderWidgets(reorderingBufer);
-    for (std::size_t i = 0; i < children_.size(); i++) {
-        children_[i] = reorderingBufer[i].second;
+    return covered;
+}
+
+void Container::composeContent(SDL_Renderer* renderer, RenderBatch &batch, const SDL_Rect &dst,
+                               const SDL_Rect &bounds, const SDL_Rect &clip) {
+    MYGUI_PROFILE_WIDGET_SCOPE("composeContent", this);
+    // nothing of the container itself shows through an opaque child covering the bounds
+    if (!cullChildren(dst.x, dst.y, bounds)) composeSelf(renderer, batch, dst, clip);
+
+    for (std::size_t i = children_.size(); i-- > 0; ) {
+        if (culled_[i]) continue;
+        Widget *child = children_[i];
+
+        SDL_Rect chldDst = child->rect();
+        chldDst.x += dst.x;
+        chldDst.y += dst.y;
+
+        SDL_Rect visible;
+        SDL_IntersectRect(&chldDst, &bounds, &visible);
+
+        // the clip rect only has to be narrowed for children sticking out of the bounds
+        bool narrowed = !SDL_RectEquals(&visible, &chldDst);
+        if (narrowed) {
+            batch.flush();
+            batch.state().setClipRect(&visible);
+        }
+
+        child->composeInto(renderer, batch, chldDst, narrowed ? visible : clip);
+
+        if (narrowed) {
+            batch.flush();
+            batch.state().setClipRect(&clip);
+        }
     }
+}
 
-    if (parent_ && needRerender_) {
-        parent_->invalidate();
+void Container::composeInto(SDL_Renderer* renderer, RenderBatch &batch, const SDL_Rect &dst, const SDL_Rect &clip) {
+    if (keepsTexture()) {
+        Widget::composeInto(renderer, batch, dst, clip);
+        return;
     }
 
-    return updated;
+    SDL_Rect bounds;
+    if (!SDL_IntersectRect(&dst, &clip, &bounds)) return;
+
+    composeContent(renderer, batch, dst, bounds, clip);
 }
 
 bool Container::render(SDL_Renderer* renderer) {
     assert(renderer);
 
     if (!needRerender_) return false;
+    MYGUI_PROFILE_WIDGET_SCOPE("render", this);
 
-    RendererGuard rendererGuard(renderer);
+    // cached descendants update their own textures first, invisible ones stay dirty until shown
+    cullChildren(0, 0, textureRect());
+    for (std::size_t i = 0; i < children_.size(); i++) {
+        if (!culled_[i]) children_[i]->render(renderer);
+    }
 
-    if (!texture_) texture_ = SDL_CreateTexture(renderer,
-                                 SDL_PIXELFORMAT_RGBA8888,
-                                 SDL_TEXTUREACCESS_TARGET,
-                                 rect_.w, rect_.h);
+    if (!keepsTexture()) {
+        finishDirectRender();
+        return true;
+    }
+
+    RenderState localState(renderer);
+    RenderBatch localBatch(localState);
+    RenderBatch &batch = UIManager_ ? UIManager_->renderBatch() : localBatch;
+    RenderStateScope stateScope(batch.state());
+
+    if (!texture_) acquireTexture(renderer);
 
     SDL_SetTextureBlendMode(texture_, SDL_BLENDMODE_BLEND);
     SDL_SetTextureAlphaMod(texture_, 255);
     
-    SDL_SetRenderTarget(renderer, texture_);
-    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    batch.state().setTarget(texture_);
+    batch.state().setViewport(nullptr); // the scope keeps the viewport of an enclosing compose
 
-    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
-    SDL_RenderClear(renderer);
+    SDL_Rect selfRect = textureRect();
+    for (const Rect &area : damage_.rects()) {
+        batch.state().setClipRect(&area);
+        batch.state().clearRect(area);
 
-    renderSelfAction(renderer);
-    
-    // render children into the texture; children should produce their own texture
-    SDL_Rect clip = { 0, 0, rect_.w, rect_.h };
-    SDL_RenderSetClipRect(renderer, &clip);
-    for (auto it = children_.rbegin(); it != children_.rend(); ++it) {
-        Widget *child = *it;
-        child->render(renderer);
-        if (child->texture()) {
-            SDL_Rect chldRect = child->rect();
-            SDL_RenderCopy(renderer, child->texture(), NULL, &chldRect);
-        }
+        composeContent(renderer, batch, selfRect, area, area);
+        batch.flush();
     }
 
+    damage_.clear();
     needRerender_ = false; 
     
     return true;
@@ -147,8 +344,15 @@ void Container::addWidget(int x, int y, Widget *widget) {
 
     if (widget->parent() == this || widget->parent() == nullptr) {
         setParentImpl(widget, this);
+        attachUIManagerImpl(widget, UIManager_);
+        setSiblingIndexImpl(widget, children_.size());
         widget->setPosition(x, y);
         children_.push_back(widget);
+        if (spatialIndex_) spatialIndex_->insert(widget, widget->rect());
+        if (widget->needsUpdate()) childWantsUpdate(widget);
+
+        Rect chldRect = widget->rect();
+        invalidate(&chldRect);
     } else {
         std::cerr << "addWidget failed : parent does not match\n";
         return;
@@ -0,0 +1,70 @@
+#include "DamageList.h"
+
+static bool touchesRect(const SDL_Rect &a, const SDL_Rect &b) {
+    return a.x <= b.x + b.w && b.x <= a.x + a.w &&
+           a.y <= b.y + b.h && b.y <= a.y + a.h;
+}
+
+DamageList::DamageList(int width, int height)
+    : bounds_(0, 0, width, height)
+{
+    addFull();
+}
+
+void DamageList::setBounds(int width, int height) {
+    bounds_.w = width;
+    bounds_.h = height;
+    addFull();
+}
+
+void DamageList::addFull() {
+    rects_.assign(1, bounds_);
+    full_ = true;
+}
+
+void DamageList::clear() {
+    rects_.clear();
+    full_ = false;
+}
+
+void DamageList::add(const SDL_Rect &rect) {
+    if (full_) return;
+
+    Rect clipped;
+    if (!SDL_IntersectRect(&rect, &bounds_, &clipped)) return;
+
+    // merge with every rect it overlaps or touches, repeat until stable
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (std::size_t i = 0; i < rects_.size(); i++) {
+            if (!touchesRect(rects_[i], clipped)) continue;
+
+            SDL_UnionRect(&rects_[i], &clipped, &clipped);
+            rects_[i] = rects_.back();
+            rects_.pop_back();
+            merged = true;
+            break;
+        }
+    }
+
+    if (rects_.size() >= MAX_DAMAGE_RECTS) {
+        for (const Rect &r : rects_) SDL_UnionRect(&r, &clipped, &clipped);
+        rects_.clear();
+    }
+
+    if (clipped.w >= bounds_.w && clipped.h >= bounds_.h) {
+        addFull();
+        return;
+    }
+
+    rects_.push_back(clipped);
+}
+
+Rect DamageList::boundingRect() const {
+    if (rects_.empty()) return Rect();
+
+    Rect result = rects_.front();
+    for (const Rect &r : rects_) SDL_UnionRect(&r, &result, &result);
+    return result;
+}
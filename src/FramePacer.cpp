@@ -0,0 +1,67 @@
+#include <algorithm>
+#include <thread>
+
+#include "FramePacer.h"
+
+FramePacer::FramePacer(double targetMs)
+    : ticksPerMs_(SDL_GetPerformanceFrequency() / 1000.0), targetMs_(targetMs)
+{
+}
+
+void FramePacer::setVSync(bool vsync, double refreshMs) {
+    vsync_ = vsync;
+    refreshMs_ = refreshMs;
+    resumed_ = true;
+}
+
+double FramePacer::intervalMs() const {
+    if (vsync_ && refreshMs_ > 0) return std::max(targetMs_, refreshMs_);
+    return targetMs_;
+}
+
+void FramePacer::beginFrame() {
+    Uint64 now = SDL_GetPerformanceCounter();
+
+    if (frameStart_ && !resumed_) {
+        deltaMs_ = toMs(now - frameStart_);
+        stats_.worstDeltaMs = std::max(stats_.worstDeltaMs, deltaMs_);
+
+        // the present blocked on vblank, a longer interval means vblanks were skipped
+        bool presentPaces = vsync_ && refreshMs_ > 0 && targetMs_ <= refreshMs_;
+        if (presentPaces && deltaMs_ > refreshMs_ * 1.5) {
+            stats_.missedFrames += static_cast<Uint64>(deltaMs_ / refreshMs_ + 0.5) - 1;
+        }
+    }
+    else {
+        // first frame or woken from an event wait: nothing to measure
+        deltaMs_ = intervalMs();
+        deadline_ = now + toTicks(targetMs_);
+    }
+
+    frameStart_ = now;
+    resumed_ = false;
+    stats_.frames++;
+}
+
+void FramePacer::wait() {
+    if (targetMs_ <= 0) return;
+    if (vsync_ && (refreshMs_ <= 0 || targetMs_ <= refreshMs_)) return;
+
+    Uint64 now = SDL_GetPerformanceCounter();
+    if (now >= deadline_) {
+        double latenessMs = toMs(now - deadline_);
+        stats_.worstLatenessMs = std::max(stats_.worstLatenessMs, latenessMs);
+        stats_.missedFrames += 1 + static_cast<Uint64>(latenessMs / targetMs_);
+
+        // start over from now instead of rushing frames to catch up
+        deadline_ = now + toTicks(targetMs_);
+        return;
+    }
+
+    // SDL_Delay may oversleep by a scheduler quantum, the last spinMs_ are spun
+    double remainingMs = toMs(deadline_ - now);
+    if (remainingMs > spinMs_) SDL_Delay(static_cast<Uint32>(remainingMs - spinMs_));
+    while (SDL_GetPerformanceCounter() < deadline_) std::this_thread::yield();
+
+    deadline_ += toTicks(targetMs_);
+}
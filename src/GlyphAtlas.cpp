@@ -0,0 +1,225 @@
+#include <cassert>
+#include <functional>
+
+#include "GlyphAtlas.h"
+#include "Common.h"
+
+static constexpr Uint32 REPLACEMENT_CODEPOINT = 0xFFFD;
+
+static Uint32 decodeUtf8(const char *&text) {
+    const unsigned char *p = reinterpret_cast<const unsigned char *>(text);
+
+    Uint32 codepoint = 0;
+    int extra = 0;
+    if      (p[0] < 0x80)           { codepoint = p[0];        extra = 0; }
+    else if ((p[0] & 0xE0) == 0xC0) { codepoint = p[0] & 0x1F; extra = 1; }
+    else if ((p[0] & 0xF0) == 0xE0) { codepoint = p[0] & 0x0F; extra = 2; }
+    else if ((p[0] & 0xF8) == 0xF0) { codepoint = p[0] & 0x07; extra = 3; }
+    else {
+        text++;
+        return REPLACEMENT_CODEPOINT;
+    }
+
+    for (int i = 1; i <= extra; i++) {
+        if ((p[i] & 0xC0) != 0x80) {
+            text += i;
+            return REPLACEMENT_CODEPOINT;
+        }
+        codepoint = (codepoint << 6) | (p[i] & 0x3F);
+    }
+
+    text += extra + 1;
+    return codepoint;
+}
+
+std::size_t GlyphAtlas::FontKeyHash::operator()(const FontKey &key) const {
+    std::size_t hash = std::hash<const void *>()(key.font);
+    hash ^= std::hash<int>()(key.height) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    hash ^= std::hash<int>()(key.style)  + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    return hash;
+}
+
+GlyphAtlas::GlyphAtlas(SDL_Renderer *renderer)
+    : renderer_(renderer)
+{
+    assert(renderer_);
+}
+
+GlyphAtlas::~GlyphAtlas() {
+    clear();
+}
+
+void GlyphAtlas::clear() {
+    for (Page &page : pages_) {
+        if (page.texture) SDL_DestroyTexture(page.texture);
+    }
+    pages_.clear();
+    fonts_.clear();
+}
+
+void GlyphAtlas::forgetFont(TTF_Font *font) {
+    for (auto it = fonts_.begin(); it != fonts_.end(); ) {
+        if (it->first.font == font) it = fonts_.erase(it);
+        else ++it;
+    }
+}
+
+GlyphAtlas::FontCache &GlyphAtlas::fontCache(TTF_Font *font) {
+    assert(font);
+
+    FontKey key = {font, TTF_FontHeight(font), TTF_GetFontStyle(font)};
+    auto it = fonts_.find(key);
+    if (it != fonts_.end()) return it->second;
+
+    FontCache &cache = fonts_[key];
+    cache.height = key.height;
+    return cache;
+}
+
+void GlyphAtlas::addPage() {
+    Page page;
+    page.texture = SDL_CreateTexture(renderer_, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC,
+                                     GLYPH_ATLAS_PAGE_SIZE, GLYPH_ATLAS_PAGE_SIZE);
+    assert(page.texture);
+    SDL_SetTextureBlendMode(page.texture, SDL_BLENDMODE_BLEND);
+
+    pages_.push_back(page);
+}
+
+bool GlyphAtlas::packGlyph(SDL_Surface *surface, Glyph &glyph) {
+    int w = surface->w + GLYPH_ATLAS_PADDING;
+    int h = surface->h + GLYPH_ATLAS_PADDING;
+    if (w > GLYPH_ATLAS_PAGE_SIZE || h > GLYPH_ATLAS_PAGE_SIZE) return false;
+
+    if (pages_.empty()) addPage();
+
+    // shelf packing: fill the current row, open a new row, then a new page
+    Page *page = &pages_.back();
+    if (page->shelfX + w > GLYPH_ATLAS_PAGE_SIZE) {
+        page->shelfX = 0;
+        page->shelfY += page->shelfH;
+        page->shelfH = 0;
+    }
+    if (page->shelfY + h > GLYPH_ATLAS_PAGE_SIZE) {
+        addPage();
+        page = &pages_.back();
+    }
+
+    glyph.page = static_cast<int>(pages_.size()) - 1;
+    glyph.src = {page->shelfX, page->shelfY, surface->w, surface->h};
+
+    page->shelfX += w;
+    if (h > page->shelfH) page->shelfH = h;
+
+    SDL_UpdateTexture(page->texture, &glyph.src, surface->pixels, surface->pitch);
+    return true;
+}
+
+const GlyphAtlas::Glyph &GlyphAtlas::glyph(TTF_Font *font, FontCache &cache, Uint32 codepoint) {
+    auto it = cache.glyphs.find(codepoint);
+    if (it != cache.glyphs.end()) return it->second;
+
+    Glyph &glyph = cache.glyphs[codepoint];
+
+    int minX = 0, maxX = 0, minY = 0, maxY = 0;
+    if (TTF_GlyphMetrics32(font, codepoint, &minX, &maxX, &minY, &maxY, &glyph.advance)) {
+        SDL_Log("TTF_GlyphMetrics32 failed: %s", TTF_GetError());
+        return glyph;
+    }
+    glyph.offsetX = (minX < 0) ? minX : 0;
+
+    SDL_Surface *rendered = TTF_RenderGlyph32_Blended(font, codepoint, WHITE_SDL_COLOR);
+    if (!rendered) return glyph;
+
+    SDL_Surface *converted = SDL_ConvertSurfaceFormat(rendered, SDL_PIXELFORMAT_ARGB8888, 0);
+    SDL_FreeSurface(rendered);
+    if (!converted) return glyph;
+
+    if (converted->w > 0 && converted->h > 0 && !packGlyph(converted, glyph)) {
+        SDL_Log("GlyphAtlas: glyph %u does not fit into an atlas page", codepoint);
+    }
+    SDL_FreeSurface(converted);
+
+    return glyph;
+}
+
+int GlyphAtlas::kerning(TTF_Font *font, FontCache &cache, Uint32 prev, Uint32 cur) {
+    Uint64 key = (static_cast<Uint64>(prev) << 32) | cur;
+    auto it = cache.kerning.find(key);
+    if (it != cache.kerning.end()) return it->second;
+
+    int kern = TTF_GetFontKerningSizeGlyphs32(font, prev, cur);
+    cache.kerning[key] = kern;
+    return kern;
+}
+
+SDL_Rect GlyphAtlas::measure(TTF_Font *font, const char text[]) {
+    assert(text);
+
+    FontCache &cache = fontCache(font);
+
+    int width = 0;
+    Uint32 prev = 0;
+    for (const char *p = text; *p; ) {
+        Uint32 codepoint = decodeUtf8(p);
+        if (prev) width += kerning(font, cache, prev, codepoint);
+        width += glyph(font, cache, codepoint).advance;
+        prev = codepoint;
+    }
+
+    return {0, 0, width, cache.height};
+}
+
+void GlyphAtlas::flush() {
+    if (batchPage_ >= 0 && !indices_.empty()) {
+        SDL_RenderGeometry(renderer_, pages_[batchPage_].texture,
+                           vertices_.data(), static_cast<int>(vertices_.size()),
+                           indices_.data(), static_cast<int>(indices_.size()));
+    }
+
+    vertices_.clear();
+    indices_.clear();
+    batchPage_ = -1;
+}
+
+SDL_Rect GlyphAtlas::drawText(TTF_Font *font, const char text[], int x, int y, SDL_Color color) {
+    assert(text);
+
+    FontCache &cache = fontCache(font);
+    const float texScale = 1.0f / GLYPH_ATLAS_PAGE_SIZE;
+
+    int penX = x;
+    Uint32 prev = 0;
+    for (const char *p = text; *p; ) {
+        Uint32 codepoint = decodeUtf8(p);
+        if (prev) penX += kerning(font, cache, prev, codepoint);
+        prev = codepoint;
+
+        const Glyph &g = glyph(font, cache, codepoint);
+        if (g.page >= 0) {
+            if (g.page != batchPage_) {
+                flush();
+                batchPage_ = g.page;
+            }
+
+            float left   = static_cast<float>(penX + g.offsetX);
+            float top    = static_cast<float>(y);
+            float right  = left + g.src.w;
+            float bottom = top + g.src.h;
+            float u0 = g.src.x * texScale, u1 = (g.src.x + g.src.w) * texScale;
+            float v0 = g.src.y * texScale, v1 = (g.src.y + g.src.h) * texScale;
+
+            int base = static_cast<int>(vertices_.size());
+            vertices_.push_back({{left,  top},    color, {u0, v0}});
+            vertices_.push_back({{right, top},    color, {u1, v0}});
+            vertices_.push_back({{right, bottom}, color, {u1, v1}});
+            vertices_.push_back({{left,  bottom}, color, {u0, v1}});
+            for (int idx : {0, 1, 2, 0, 2, 3}) indices_.push_back(base + idx);
+        }
+
+        penX += g.advance;
+    }
+
+    flush();
+    return {x, y, penX - x, cache.height};
+}
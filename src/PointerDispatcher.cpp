@@ -0,0 +1,111 @@
+#include <algorithm>
+
+#include "PointerDispatcher.h"
+#include "Widget.h"
+#include "Profiler.h"
+
+// the first child at or below child that is not a layer
+Widget *PointerDispatcher::contentChild(const Widget *parent, Widget *child, int x, int y) {
+    while (child && child->isLayer()) child = parent->childBelowAt(child, x, y);
+    return child;
+}
+
+void PointerDispatcher::descend(Widget *wgt, gm_dot<int, 2> origin, const gm_dot<int, 2> &pos) {
+    while (wgt && !wgt->isHiden()) {
+        Rect wgtRect = wgt->rect();
+        if (!isInsideRect(wgtRect, pos.x - origin.x, pos.y - origin.y)) break;
+
+        path_.push_back({wgt, origin});
+        origin.x += wgtRect.x;
+        origin.y += wgtRect.y;
+        int x = pos.x - origin.x, y = pos.y - origin.y;
+        wgt = contentChild(wgt, wgt->childAt(x, y), x, y);
+    }
+}
+
+void PointerDispatcher::hitTest(Widget *root, const gm_dot<int, 2> &pos) {
+    path_.clear();
+    descend(root, {0, 0}, pos);
+}
+
+void PointerDispatcher::hitTestLayer(Widget *layer, const gm_dot<int, 2> &pos) {
+    path_.clear();
+
+    // ancestors leaf -> root first, their origins are known once the root is reached
+    for (Widget *wgt = layer->parent(); wgt; wgt = wgt->parent()) path_.push_back({wgt, {0, 0}});
+    std::reverse(path_.begin(), path_.end());
+
+    gm_dot<int, 2> origin = {0, 0};
+    for (HitPathEntry &entry : path_) {
+        entry.origin = origin;
+        Rect wgtRect = entry.widget->rect();
+        origin.x += wgtRect.x;
+        origin.y += wgtRect.y;
+    }
+
+    descend(layer, origin, pos);
+}
+
+// wgt contains the point, origin is the screen position of its parent's coordinate space
+template <typename Event>
+bool PointerDispatcher::bubbleSubtree(Widget *wgt, const gm_dot<int, 2> &origin, const Event &event,
+                                      bool (Widget::*bubble)(const Event &)) {
+    Rect wgtRect = wgt->rect();
+    gm_dot<int, 2> childOrigin = {origin.x + wgtRect.x, origin.y + wgtRect.y};
+    int x = event.pos.x - childOrigin.x, y = event.pos.y - childOrigin.y;
+    for (Widget *child = contentChild(wgt, wgt->childAt(x, y), x, y); child;
+         child = contentChild(wgt, wgt->childBelowAt(child, x, y), x, y)) {
+        if (bubbleSubtree(child, childOrigin, event, bubble) == CONSUME) return CONSUME;
+    }
+
+    Event local = event;
+    local.pos.x -= origin.x;
+    local.pos.y -= origin.y;
+    return (wgt->*bubble)(local);
+}
+
+template <typename Event>
+bool PointerDispatcher::dispatch(const Event &event,
+                                 bool (Widget::*capture)(const Event &),
+                                 bool (Widget::*bubble)(const Event &)) const {
+    for (const HitPathEntry &entry : path_) {
+        Event local = event;
+        local.pos.x -= entry.origin.x;
+        local.pos.y -= entry.origin.y;
+        if ((entry.widget->*capture)(local) == CONSUME) return CONSUME;
+    }
+
+    for (std::size_t i = path_.size(); i-- > 0;) {
+        const HitPathEntry &entry = path_[i];
+        MYGUI_PROFILE_WIDGET_SCOPE("pointer", entry.widget);
+
+        // the hit child propagated: the siblings under it get the event before this level
+        if (i + 1 < path_.size()) {
+            const HitPathEntry &hit = path_[i + 1];
+            int x = event.pos.x - hit.origin.x, y = event.pos.y - hit.origin.y;
+            for (Widget *sibling = contentChild(entry.widget, entry.widget->childBelowAt(hit.widget, x, y), x, y); sibling;
+                 sibling = contentChild(entry.widget, entry.widget->childBelowAt(sibling, x, y), x, y)) {
+                if (bubbleSubtree(sibling, hit.origin, event, bubble) == CONSUME) return CONSUME;
+            }
+        }
+
+        Event local = event;
+        local.pos.x -= entry.origin.x;
+        local.pos.y -= entry.origin.y;
+        if ((entry.widget->*bubble)(local) == CONSUME) return CONSUME;
+    }
+
+    return PROPAGATE;
+}
+
+bool PointerDispatcher::mouseDown(const MouseButtonEvent &event) const {
+    return dispatch(event, &Widget::onMouseDownCapture, &Widget::onMouseDownSelfAction);
+}
+
+bool PointerDispatcher::mouseUp(const MouseButtonEvent &event) const {
+    return dispatch(event, &Widget::onMouseUpCapture, &Widget::onMouseUpSelfAction);
+}
+
+bool PointerDispatcher::mouseMove(const MouseMotionEvent &event) const {
+    return dispatch(event, &Widget::onMouseMoveCapture, &Widget::onMouseMoveSelfAction);
+}
@@ -0,0 +1,136 @@
+#include <algorithm>
+#include <fstream>
+#include <vector>
+
+#include "Profiler.h"
+
+static_assert((PROFILER_SAMPLES_CAPACITY & (PROFILER_SAMPLES_CAPACITY - 1)) == 0,
+              "PROFILER_SAMPLES_CAPACITY must be a power of two");
+
+Profiler::Profiler()
+    : samples_(new Sample[PROFILER_SAMPLES_CAPACITY]),
+      origin_(SDL_GetPerformanceCounter()),
+      ticksPerUs_(static_cast<double>(SDL_GetPerformanceFrequency()) / 1e6)
+{}
+
+Profiler &Profiler::instance() {
+    static Profiler profiler;
+    return profiler;
+}
+
+Uint32 Profiler::threadIndex() {
+    static std::atomic<Uint32> nextIndex{0};
+    thread_local Uint32 index = nextIndex.fetch_add(1, std::memory_order_relaxed);
+    return index;
+}
+
+void Profiler::record(const char *name, const char *detail, const void *object, Uint64 start, Uint64 end) {
+    Uint64 index = head_.fetch_add(1, std::memory_order_relaxed);
+    Sample &sample = samples_[index & (PROFILER_SAMPLES_CAPACITY - 1)];
+
+    // readers skip the slot while it is being overwritten
+    sample.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    sample.name = name;
+    sample.detail = detail;
+    sample.object = object;
+    sample.start = start;
+    sample.duration = end - start;
+    sample.thread = threadIndex();
+
+    sample.sequence.store(index + 1, std::memory_order_release);
+}
+
+void Profiler::frameEnd() {
+    Uint64 end = now();
+    frames_[framesCount_ % PROFILER_FRAMES_CAPACITY] = (end - frameStart_) / ticksPerUs_ / 1000.0;
+    framesCount_++;
+    record("frame", nullptr, nullptr, frameStart_, end);
+}
+
+FrameStats Profiler::frameStats() const {
+    FrameStats stats;
+    stats.frames = std::min(framesCount_, PROFILER_FRAMES_CAPACITY);
+    if (!stats.frames) return stats;
+
+    std::vector<double> sorted(frames_, frames_ + stats.frames);
+    std::sort(sorted.begin(), sorted.end());
+
+    auto percentile = [&](double p) { return sorted[static_cast<std::size_t>(p * (sorted.size() - 1) + 0.5)]; };
+    stats.p50Ms = percentile(0.50);
+    stats.p99Ms = percentile(0.99);
+    stats.maxMs = sorted.back();
+    return stats;
+}
+
+void Profiler::printSummary(std::ostream &out) const {
+    FrameStats stats = frameStats();
+    out << "frames " << stats.frames
+        << "  p50 " << stats.p50Ms << " ms"
+        << "  p99 " << stats.p99Ms << " ms"
+        << "  max " << stats.maxMs << " ms" << std::endl;
+}
+
+static void writeJsonString(std::ostream &out, const char *text) {
+    out << '"';
+    for (const char *c = text; *c; c++) {
+        if (*c == '"' || *c == '\\') out << '\\';
+        if (static_cast<unsigned char>(*c) >= 0x20) out << *c;
+    }
+    out << '"';
+}
+
+bool Profiler::writeChromeTrace(const char *path) const {
+    std::ofstream out(path);
+    if (!out) return false;
+
+    Uint64 head = head_.load(std::memory_order_acquire);
+    Uint64 first = head > PROFILER_SAMPLES_CAPACITY ? head - PROFILER_SAMPLES_CAPACITY : 0;
+
+    out << "{\"traceEvents\":[";
+    bool separator = false;
+    for (Uint64 index = first; index < head; index++) {
+        const Sample &sample = samples_[index & (PROFILER_SAMPLES_CAPACITY - 1)];
+        if (sample.sequence.load(std::memory_order_acquire) != index + 1) continue;
+
+        const char *name = sample.name;
+        const char *detail = sample.detail;
+        const void *object = sample.object;
+        Uint64 start = sample.start;
+        Uint64 duration = sample.duration;
+        Uint32 thread = sample.thread;
+
+        // overwritten while copying
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sample.sequence.load(std::memory_order_relaxed) != index + 1) continue;
+
+        if (separator) out << ',';
+        separator = true;
+
+        out << "\n{\"name\":";
+        writeJsonString(out, name ? name : "?");
+        out << ",\"cat\":\"" << (object ? "widget" : "stage") << "\",\"ph\":\"X\""
+            << ",\"ts\":" << static_cast<Sint64>(start - origin_) / ticksPerUs_
+            << ",\"dur\":" << duration / ticksPerUs_
+            << ",\"pid\":0,\"tid\":" << thread;
+        if (object) {
+            out << ",\"args\":{\"widget\":\"" << object << "\"";
+            if (detail) {
+                out << ",\"type\":";
+                writeJsonString(out, detail);
+            }
+            out << '}';
+        }
+        out << '}';
+    }
+    out << "\n]}\n";
+
+    return static_cast<bool>(out);
+}
+
+void Profiler::clear() {
+    for (std::size_t i = 0; i < PROFILER_SAMPLES_CAPACITY; i++) samples_[i].sequence.store(0, std::memory_order_relaxed);
+    head_.store(0, std::memory_order_release);
+    framesCount_ = 0;
+}
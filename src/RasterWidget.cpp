@@ -0,0 +1,157 @@
+#include <cassert>
+
+#include "RasterWidget.h"
+#include "UIManager.h"
+#include "RenderBatch.h"
+#include "ThreadPool.h"
+
+RasterWidget::RasterWidget(int width, int height, Widget *parent)
+    : Widget(width, height, parent)
+{
+    // first raster once the widget is added, addWidget enlists it
+    rasterPending_ = true;
+    pendingArea_ = Rect(0, 0, width, height);
+    wantsUpdate_ = true;
+}
+
+RasterWidget::~RasterWidget() {
+    // a running job keeps its buffer alive and finishes unobserved
+    if (streamTexture_) SDL_DestroyTexture(streamTexture_);
+}
+
+void RasterWidget::requestRaster(const SDL_Rect *rect) {
+    Rect area = rect ? Rect(*rect) : Rect(0, 0, rect_.w, rect_.h);
+    if (area.w <= 0 || area.h <= 0) return;
+
+    if (rasterPending_) SDL_UnionRect(&pendingArea_, &area, &pendingArea_);
+    else pendingArea_ = area;
+    rasterPending_ = true;
+    setWantsUpdate(true);
+}
+
+void RasterWidget::startRaster() {
+    rasterPending_ = false;
+
+    if (!buffer_ || buffer_->width != rect_.w || buffer_->height != rect_.h) {
+        buffer_ = std::make_shared<RasterBuffer>();
+        buffer_->width = rect_.w;
+        buffer_->height = rect_.h;
+        buffer_->pixels.assign(static_cast<std::size_t>(rect_.w) * rect_.h, 0);
+        pendingArea_ = Rect(0, 0, rect_.w, rect_.h); // nothing to keep
+    }
+
+    Rect bounds(0, 0, rect_.w, rect_.h);
+    Rect area;
+    if (!SDL_IntersectRect(&pendingArea_, &bounds, &area)) return;
+
+    RasterFunction draw = prepareRaster();
+    assert(draw);
+
+    std::shared_ptr<RasterBuffer> buffer = buffer_;
+    buffer->area = area;
+    rasterizing_ = true;
+
+    auto job = [buffer, draw = std::move(draw)] {
+        draw(buffer->pixels.data(), buffer->width, buffer->area);
+        buffer->ready.store(true, std::memory_order_release);
+    };
+
+    if (!UIManager_) {
+        job();
+        return;
+    }
+
+    UIManager *manager = UIManager_;
+    manager->rasterPool().submit([job = std::move(job), manager] {
+        job();
+        manager->post([] {}); // wakes an event-driven loop, update() picks the result up
+    });
+}
+
+bool RasterWidget::updateSelfAction() {
+    bool changed = false;
+
+    if (rasterizing_ && buffer_->ready.load(std::memory_order_acquire)) {
+        rasterizing_ = false;
+        invalidate(&buffer_->area); // render() uploads it
+        changed = true;
+    }
+
+    // the buffer is reused, wait until the finished raster has been uploaded
+    bool uploadPending = buffer_ && buffer_->ready.load(std::memory_order_acquire);
+    if (rasterPending_ && !rasterizing_ && !uploadPending && !startPosted_) {
+        // prepareRaster reads the model on the UI thread, a parallel update may run on a worker
+        if (inParallelUpdate()) {
+            if (!lifetime_) lifetime_ = std::make_shared<RasterWidget *>(this);
+            startPosted_ = true;
+            UIManager_->post([widget = std::weak_ptr<RasterWidget *>(lifetime_)] {
+                std::shared_ptr<RasterWidget *> alive = widget.lock();
+                if (!alive) return;
+
+                RasterWidget *self = *alive;
+                self->startPosted_ = false;
+                if (self->rasterPending_ && !self->rasterizing_) self->startRaster();
+            });
+        }
+        else startRaster();
+    }
+
+    setWantsUpdate(rasterizing_ || rasterPending_);
+    return changed;
+}
+
+void RasterWidget::uploadRaster(SDL_Renderer* renderer) {
+    RasterBuffer &buffer = *buffer_;
+    buffer.ready.store(false, std::memory_order_relaxed);
+
+    if (buffer.width != rect_.w || buffer.height != rect_.h) {
+        requestRaster(); // resized meanwhile
+        return;
+    }
+
+    if (!streamTexture_ || streamRenderer_ != renderer
+        || streamWidth_ != buffer.width || streamHeight_ != buffer.height) {
+        if (streamTexture_) SDL_DestroyTexture(streamTexture_);
+        streamTexture_ = SDL_CreateTexture(renderer,
+                                           SDL_PIXELFORMAT_ARGB8888,
+                                           SDL_TEXTUREACCESS_STREAMING,
+                                           buffer.width, buffer.height);
+        assert(streamTexture_);
+        SDL_SetTextureBlendMode(streamTexture_, SDL_BLENDMODE_BLEND);
+
+        streamRenderer_ = renderer;
+        streamWidth_ = buffer.width;
+        streamHeight_ = buffer.height;
+        hasPixels_ = false;
+    }
+
+    // a new texture gets the whole buffer, it already holds the earlier rasters
+    Rect area = hasPixels_ ? buffer.area : Rect(0, 0, buffer.width, buffer.height);
+    const Uint32 *pixels = buffer.pixels.data() + static_cast<std::size_t>(area.y) * buffer.width + area.x;
+    SDL_UpdateTexture(streamTexture_, &area, pixels, buffer.width * static_cast<int>(sizeof(Uint32)));
+    hasPixels_ = true;
+}
+
+bool RasterWidget::render(SDL_Renderer* renderer) {
+    if (buffer_ && !rasterizing_ && buffer_->ready.load(std::memory_order_acquire)) uploadRaster(renderer);
+    else if (buffer_ && !rasterPending_ && (buffer_->width != rect_.w || buffer_->height != rect_.h)) requestRaster();
+
+    return Widget::render(renderer);
+}
+
+void RasterWidget::renderSelfAction(SDL_Renderer* renderer) {
+    if (!hasPixels_) return;
+
+    SDL_Rect full = {0, 0, rect_.w, rect_.h};
+    SDL_RenderCopy(renderer, streamTexture_, nullptr, &full);
+}
+
+void RasterWidget::composeInto(SDL_Renderer* renderer, RenderBatch &batch, const SDL_Rect &dst, const SDL_Rect &clip) {
+    if (keepsTexture()) {
+        Widget::composeInto(renderer, batch, dst, clip);
+        return;
+    }
+
+    // direct: the streaming texture is blitted like a cached one, no viewport switch
+    if (hasPixels_) batch.copy(streamTexture_, Rect(0, 0, streamWidth_, streamHeight_), dst, opacity_);
+}
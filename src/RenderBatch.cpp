@@ -0,0 +1,67 @@
+#include <cassert>
+
+#include "RenderBatch.h"
+
+RenderBatch::RenderBatch(RenderState &state)
+    : state_(state), renderer_(state.renderer())
+{
+    assert(renderer_);
+}
+
+RenderBatch::~RenderBatch() {
+    flush();
+}
+
+void RenderBatch::pushQuad(const SDL_Rect &dst, SDL_Color color, float u0, float v0, float u1, float v1) {
+    float left   = static_cast<float>(dst.x);
+    float top    = static_cast<float>(dst.y);
+    float right  = static_cast<float>(dst.x + dst.w);
+    float bottom = static_cast<float>(dst.y + dst.h);
+
+    int base = static_cast<int>(vertices_.size());
+    vertices_.push_back({{left,  top},    color, {u0, v0}});
+    vertices_.push_back({{right, top},    color, {u1, v0}});
+    vertices_.push_back({{right, bottom}, color, {u1, v1}});
+    vertices_.push_back({{left,  bottom}, color, {u0, v1}});
+    for (int idx : {0, 1, 2, 0, 2, 3}) indices_.push_back(base + idx);
+
+    quads_++;
+}
+
+void RenderBatch::fillRect(const SDL_Rect &rect, SDL_Color color) {
+    if (rect.w <= 0 || rect.h <= 0) return;
+
+    if (texture_) flush();
+    pushQuad(rect, color, 0, 0, 0, 0);
+}
+
+void RenderBatch::copy(SDL_Texture *texture, const SDL_Rect &src, const SDL_Rect &dst, Uint8 alpha) {
+    assert(texture);
+    if (dst.w <= 0 || dst.h <= 0) return;
+
+    if (texture != texture_) {
+        flush();
+        texture_ = texture;
+    }
+
+    int texW = 1, texH = 1;
+    SDL_QueryTexture(texture, nullptr, nullptr, &texW, &texH);
+
+    float u0 = static_cast<float>(src.x) / texW, u1 = static_cast<float>(src.x + src.w) / texW;
+    float v0 = static_cast<float>(src.y) / texH, v1 = static_cast<float>(src.y + src.h) / texH;
+    pushQuad(dst, {255, 255, 255, alpha}, u0, v0, u1, v1);
+}
+
+void RenderBatch::flush() {
+    if (!indices_.empty()) {
+        state_.apply(RenderState::GEOMETRY);
+        SDL_RenderGeometry(renderer_, texture_,
+                           vertices_.data(), static_cast<int>(vertices_.size()),
+                           indices_.data(), static_cast<int>(indices_.size()));
+        drawCalls_++;
+    }
+
+    vertices_.clear();
+    indices_.clear();
+    texture_ = nullptr;
+}
@@ -0,0 +1,157 @@
+#include <cassert>
+
+#include "RenderState.h"
+
+static bool sameColor(const SDL_Color &a, const SDL_Color &b) {
+    return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+}
+
+static bool sameRect(bool hasA, const SDL_Rect &a, bool hasB, const SDL_Rect &b) {
+    if (!hasA || !hasB) return hasA == hasB;
+    return a.x == b.x && a.y == b.y && a.w == b.w && a.h == b.h;
+}
+
+RenderState::RenderState(SDL_Renderer *renderer)
+    : renderer_(renderer)
+{
+    assert(renderer_);
+}
+
+void RenderState::query(Uint8 fields) {
+    fields &= ~known_;
+
+    // the renderer's current values become both wanted and applied
+    if (fields & TARGET) {
+        applied_.target = SDL_GetRenderTarget(renderer_);
+        wanted_.target = applied_.target;
+        queried_++;
+    }
+    if (fields & COLOR) {
+        SDL_GetRenderDrawColor(renderer_, &applied_.color.r, &applied_.color.g, &applied_.color.b, &applied_.color.a);
+        wanted_.color = applied_.color;
+        queried_++;
+    }
+    if (fields & BLEND) {
+        SDL_GetRenderDrawBlendMode(renderer_, &applied_.blend);
+        wanted_.blend = applied_.blend;
+        queried_++;
+    }
+    if (fields & VIEWPORT) {
+        // the whole target is reported as a rect, restoring it as one is equivalent
+        SDL_RenderGetViewport(renderer_, &applied_.viewport);
+        applied_.hasViewport = true;
+        wanted_.hasViewport = true;
+        wanted_.viewport = applied_.viewport;
+        queried_++;
+    }
+    if (fields & CLIP) {
+        applied_.hasClip = SDL_RenderIsClipEnabled(renderer_);
+        if (applied_.hasClip) SDL_RenderGetClipRect(renderer_, &applied_.clip);
+        wanted_.hasClip = applied_.hasClip;
+        wanted_.clip = applied_.clip;
+        queried_ += applied_.hasClip ? 2 : 1;
+    }
+
+    known_ |= fields;
+    synced_ |= fields;
+}
+
+void RenderState::setTarget(SDL_Texture *target) {
+    request(TARGET);
+    wanted_.target = target;
+}
+
+void RenderState::setDrawColor(SDL_Color color) {
+    request(COLOR);
+    wanted_.color = color;
+}
+
+void RenderState::setBlendMode(SDL_BlendMode mode) {
+    request(BLEND);
+    wanted_.blend = mode;
+}
+
+void RenderState::setViewport(const SDL_Rect *rect) {
+    request(VIEWPORT);
+    wanted_.hasViewport = rect != nullptr;
+    if (rect) wanted_.viewport = *rect;
+}
+
+void RenderState::setClipRect(const SDL_Rect *rect) {
+    request(CLIP);
+    wanted_.hasClip = rect != nullptr;
+    if (rect) wanted_.clip = *rect;
+}
+
+void RenderState::request(Field field) {
+    // overwritten before it reached SDL
+    if (pending_ & field) skipped_++;
+
+    pending_ |= field;
+    known_ |= field;
+}
+
+bool RenderState::needsIssue(Field field, bool same) {
+    if (!(known_ & field)) return false;
+
+    bool requested = pending_ & field;
+    pending_ &= ~field;
+    if ((synced_ & field) && same) {
+        if (requested) skipped_++;
+        return false;
+    }
+
+    synced_ |= field;
+    issued_++;
+    return true;
+}
+
+void RenderState::apply(Uint8 fields) {
+    fields &= known_;
+
+    // the target first, SDL resets or restores the viewport and clip rect with it
+    if ((fields & TARGET) && needsIssue(TARGET, applied_.target == wanted_.target)) {
+        SDL_SetRenderTarget(renderer_, wanted_.target);
+        applied_.target = wanted_.target;
+        synced_ &= ~(VIEWPORT | CLIP);
+    }
+    if ((fields & COLOR) && needsIssue(COLOR, sameColor(applied_.color, wanted_.color))) {
+        SDL_SetRenderDrawColor(renderer_, wanted_.color.r, wanted_.color.g, wanted_.color.b, wanted_.color.a);
+        applied_.color = wanted_.color;
+    }
+    if ((fields & BLEND) && needsIssue(BLEND, applied_.blend == wanted_.blend)) {
+        SDL_SetRenderDrawBlendMode(renderer_, wanted_.blend);
+        applied_.blend = wanted_.blend;
+    }
+    if ((fields & VIEWPORT) && needsIssue(VIEWPORT, sameRect(applied_.hasViewport, applied_.viewport, wanted_.hasViewport, wanted_.viewport))) {
+        SDL_RenderSetViewport(renderer_, wanted_.hasViewport ? &wanted_.viewport : nullptr);
+        applied_.hasViewport = wanted_.hasViewport;
+        applied_.viewport = wanted_.viewport;
+    }
+    if ((fields & CLIP) && needsIssue(CLIP, sameRect(applied_.hasClip, applied_.clip, wanted_.hasClip, wanted_.clip))) {
+        SDL_RenderSetClipRect(renderer_, wanted_.hasClip ? &wanted_.clip : nullptr);
+        applied_.hasClip = wanted_.hasClip;
+        applied_.clip = wanted_.clip;
+    }
+}
+
+void RenderState::clearRect(const SDL_Rect &rect) {
+    setBlendMode(SDL_BLENDMODE_NONE);
+    setDrawColor({0, 0, 0, 0});
+    apply();
+    SDL_RenderFillRect(renderer_, &rect);
+    setBlendMode(SDL_BLENDMODE_BLEND);
+}
+
+void RenderState::push() {
+    query(ALL);
+    stack_.push_back(wanted_);
+}
+
+void RenderState::pop() {
+    assert(!stack_.empty());
+    wanted_ = stack_.back();
+    stack_.pop_back();
+
+    for (Field field : {TARGET, COLOR, BLEND, VIEWPORT, CLIP}) request(field);
+}
@@ -0,0 +1,242 @@
+#include <cassert>
+#include <algorithm>
+
+#include "Scheduler.h"
+
+Scheduler::Scheduler(Uint64 nowMs)
+    : now_(nowMs)
+{
+    std::fill(&wheel_[0][0], &wheel_[0][0] + SCHEDULER_LEVELS * SLOTS, NONE);
+}
+
+Sint32 Scheduler::allocate(Callback callback, Uint32 period) {
+    Sint32 index;
+    if (!free_.empty()) {
+        index = free_.back();
+        free_.pop_back();
+    }
+    else {
+        index = static_cast<Sint32>(timers_.size());
+        timers_.emplace_back();
+    }
+
+    Timer &timer = timers_[index];
+    timer.callback = std::move(callback);
+    timer.period = period;
+    timer.lastRun = now_;
+    timer.active = true;
+    pending_++;
+    return index;
+}
+
+void Scheduler::release(Sint32 index) {
+    Timer &timer = timers_[index];
+    timer.callback = nullptr;
+    timer.active = false;
+    timer.generation++; // outstanding handles go stale
+    free_.push_back(index);
+    pending_--;
+}
+
+void Scheduler::link(Sint32 index, Sint32 *list) {
+    Timer &timer = timers_[index];
+    timer.list = list;
+    timer.prev = NONE;
+    timer.next = *list;
+    if (*list != NONE) timers_[*list].prev = index;
+    *list = index;
+}
+
+void Scheduler::unlink(Sint32 index) {
+    Timer &timer = timers_[index];
+    if (!timer.list) return;
+
+    if (timer.prev != NONE) timers_[timer.prev].next = timer.next;
+    else *timer.list = timer.next;
+    if (timer.next != NONE) timers_[timer.next].prev = timer.prev;
+
+    timer.list = nullptr;
+    timer.prev = timer.next = NONE;
+}
+
+void Scheduler::insert(Sint32 index) {
+    Timer &timer = timers_[index];
+    assert(timer.deadline >= now_);
+
+    // the lowest level whose span covers the delay; later deadlines wait in the top level
+    // and are re-inserted by the cascade. A cascaded timer due now lands in the current
+    // level 0 slot, which advance() collects right after cascading.
+    Uint64 deadline = timer.deadline;
+    int level = 0;
+    while (level < SCHEDULER_LEVELS - 1 && deadline - now_ >= (Uint64(1) << (SCHEDULER_SLOT_BITS * (level + 1)))) level++;
+
+    Uint64 span = Uint64(1) << (SCHEDULER_SLOT_BITS * SCHEDULER_LEVELS);
+    if (deadline - now_ >= span) deadline = now_ + span - 1;
+
+    int slot = static_cast<int>((deadline >> (SCHEDULER_SLOT_BITS * level)) & (SLOTS - 1));
+    link(index, &wheel_[level][slot]);
+}
+
+void Scheduler::cascade(int level) {
+    int slot = static_cast<int>((now_ >> (SCHEDULER_SLOT_BITS * level)) & (SLOTS - 1));
+    Sint32 index = wheel_[level][slot];
+    wheel_[level][slot] = NONE;
+
+    while (index != NONE) {
+        Sint32 next = timers_[index].next;
+        timers_[index].list = nullptr;
+        insert(index);
+        index = next;
+    }
+}
+
+void Scheduler::collect(Sint32 *list) {
+    Sint32 index = *list;
+    *list = NONE;
+
+    while (index != NONE) {
+        Sint32 next = timers_[index].next;
+        timers_[index].list = nullptr;
+        timers_[index].prev = timers_[index].next = NONE;
+        due_.push_back(index);
+        index = next;
+    }
+}
+
+void Scheduler::run(Sint32 index) {
+    Timer &timer = timers_[index];
+    if (!timer.active || timer.list) return; // cancelled or rescheduled by an earlier callback
+
+    Uint32 delta = static_cast<Uint32>(now_ - timer.lastRun);
+    timer.lastRun = now_;
+
+    if (!timer.period) {
+        // released first, the callback may schedule into the same pool slot
+        Callback callback = std::move(timer.callback);
+        release(index);
+        callback(delta);
+        return;
+    }
+
+    // missed periods are skipped instead of run back to back
+    timer.deadline = std::max(timer.deadline + timer.period, now_ + 1);
+    insert(index);
+
+    // moved out while running: the pool may grow or the callback may cancel its own timer
+    Uint32 generation = timer.generation;
+    Callback callback = std::move(timer.callback);
+    callback(delta);
+
+    Timer &current = timers_[index];
+    if (current.active && current.generation == generation) current.callback = std::move(callback);
+}
+
+TimerHandle Scheduler::after(Uint32 delayMs, Callback callback) {
+    assert(callback);
+
+    // the current slot was collected by the last advance(), a zero delay runs on the next one
+    Sint32 index = allocate(std::move(callback), 0);
+    timers_[index].deadline = now_ + std::max<Uint32>(delayMs, 1);
+    insert(index);
+    return {(Uint64(timers_[index].generation) << 32) | Uint64(index + 1)};
+}
+
+TimerHandle Scheduler::every(Uint32 periodMs, Callback callback) {
+    assert(callback);
+
+    Sint32 index = allocate(std::move(callback), std::max<Uint32>(periodMs, 1));
+    timers_[index].deadline = now_ + timers_[index].period;
+    insert(index);
+    return {(Uint64(timers_[index].generation) << 32) | Uint64(index + 1)};
+}
+
+TimerHandle Scheduler::postToNextFrame(Callback callback) {
+    assert(callback);
+
+    Sint32 index = allocate(std::move(callback), 0);
+    link(index, &nextFrame_);
+    return {(Uint64(timers_[index].generation) << 32) | Uint64(index + 1)};
+}
+
+Scheduler::Timer *Scheduler::find(TimerHandle handle) {
+    return const_cast<Timer *>(static_cast<const Scheduler *>(this)->find(handle));
+}
+
+const Scheduler::Timer *Scheduler::find(TimerHandle handle) const {
+    Sint64 index = static_cast<Sint64>(handle.id & 0xffffffff) - 1;
+    Uint32 generation = static_cast<Uint32>(handle.id >> 32);
+    if (index < 0 || index >= static_cast<Sint64>(timers_.size())) return nullptr;
+
+    const Timer &timer = timers_[index];
+    return timer.active && timer.generation == generation ? &timer : nullptr;
+}
+
+bool Scheduler::cancel(TimerHandle &handle) {
+    Timer *timer = find(handle);
+    handle = {};
+    if (!timer) return false;
+
+    Sint32 index = static_cast<Sint32>(timer - timers_.data());
+    unlink(index);
+    release(index);
+    return true;
+}
+
+std::size_t Scheduler::advance(Uint64 nowMs) {
+    due_.clear();
+    collect(&nextFrame_);
+
+    if (nowMs > now_ && pending_ > due_.size()) {
+        while (now_ < nowMs) {
+            now_++;
+
+            // entering a new block of an upper level moves its timers down
+            for (int level = 1; level < SCHEDULER_LEVELS; level++) {
+                if (now_ & ((Uint64(1) << (SCHEDULER_SLOT_BITS * level)) - 1)) break;
+                cascade(level);
+            }
+
+            collect(&wheel_[0][now_ & (SLOTS - 1)]);
+        }
+    }
+    now_ = std::max(now_, nowMs);
+
+    // callbacks run after the wheel is settled, they may schedule and cancel freely
+    std::size_t ran = 0;
+    for (std::size_t i = 0; i < due_.size(); i++) {
+        if (!timers_[due_[i]].active) continue;
+        run(due_[i]);
+        ran++;
+    }
+    return ran;
+}
+
+bool Scheduler::timeUntilNext(Uint64 nowMs, Uint32 &ms) const {
+    if (!pending_) return false;
+
+    auto left = [&](Uint64 deadline) {
+        ms = deadline > nowMs ? static_cast<Uint32>(std::min<Uint64>(deadline - nowMs, SDL_MAX_UINT32)) : 0;
+        return true;
+    };
+    if (nextFrame_ != NONE) return left(0);
+
+    // the first non-empty slot ahead at each level holds that level's earliest deadlines,
+    // upper levels may still hold a deadline earlier than the lower ones
+    bool found = false;
+    Uint64 earliest = 0;
+    for (int level = 0; level < SCHEDULER_LEVELS; level++) {
+        Uint64 block = now_ >> (SCHEDULER_SLOT_BITS * level);
+        for (Uint64 k = 1; k <= SLOTS; k++) {
+            Sint32 index = wheel_[level][(block + k) & (SLOTS - 1)];
+            if (index == NONE) continue;
+
+            for (; index != NONE; index = timers_[index].next) {
+                if (!found || timers_[index].deadline < earliest) earliest = timers_[index].deadline;
+                found = true;
+            }
+            break;
+        }
+    }
+
+    return left(found ? earliest : now_ + 1);
+}
@@ -0,0 +1,254 @@
+#include <algorithm>
+#include <cassert>
+
+#include "SoftCompositor.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MYGUI_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define MYGUI_NEON_SIMD 1
+#include <arm_neon.h>
+#endif
+
+// pixels of the solid color buffer handed to the blend kernel
+static constexpr int COLOR_SPAN = 64;
+
+// a * b / 255, rounded exactly; all kernels use this formula
+static inline Uint32 mulDiv255(Uint32 a, Uint32 b) {
+    Uint32 t = a * b + 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+static inline Uint32 blendPixel(Uint32 dst, Uint32 src, Uint32 opacity) {
+    Uint32 out = 0;
+    Uint32 srcAlpha = mulDiv255(src >> 24, opacity);
+    Uint32 inv = 255 - srcAlpha;
+
+    for (int shift = 0; shift < 32; shift += 8) {
+        Uint32 s = mulDiv255((src >> shift) & 0xff, opacity);
+        Uint32 d = mulDiv255((dst >> shift) & 0xff, inv);
+        out |= std::min<Uint32>(s + d, 255) << shift;
+    }
+    return out;
+}
+
+static void blendScalar(Uint32 *dst, const Uint32 *src, int count, Uint8 opacity) {
+    for (int i = 0; i < count; i++) {
+        // same results as blendPixel, only cheaper
+        if (!src[i]) continue;
+        if (opacity == 255 && (src[i] >> 24) == 255) dst[i] = src[i];
+        else dst[i] = blendPixel(dst[i], src[i], opacity);
+    }
+}
+
+#ifdef MYGUI_X86_SIMD
+// 16-bit lanes, at most 65407 before the shift
+__attribute__((target("sse4.1")))
+static inline __m128i mulDiv255Sse(__m128i a, __m128i b) {
+    __m128i t = _mm_add_epi16(_mm_mullo_epi16(a, b), _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+// two pixels widened to 16 bits per channel
+__attribute__((target("sse4.1")))
+static inline __m128i blendWideSse(__m128i dst, __m128i src, __m128i opacity) {
+    __m128i s = mulDiv255Sse(src, opacity);
+    __m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, 0xff), 0xff);
+    __m128i inv = _mm_sub_epi16(_mm_set1_epi16(255), alpha);
+    return _mm_add_epi16(s, mulDiv255Sse(dst, inv)); // saturated by the pack
+}
+
+__attribute__((target("sse4.1")))
+static void blendSse41(Uint32 *dst, const Uint32 *src, int count, Uint8 opacity) {
+    __m128i op = _mm_set1_epi16(opacity);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + i));
+
+        __m128i lo = blendWideSse(_mm_cvtepu8_epi16(d), _mm_cvtepu8_epi16(s), op);
+        __m128i hi = blendWideSse(_mm_cvtepu8_epi16(_mm_srli_si128(d, 8)), _mm_cvtepu8_epi16(_mm_srli_si128(s, 8)), op);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_packus_epi16(lo, hi));
+    }
+    blendScalar(dst + i, src + i, count - i, opacity);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i mulDiv255Avx(__m256i a, __m256i b) {
+    __m256i t = _mm256_add_epi16(_mm256_mullo_epi16(a, b), _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+
+// four pixels widened to 16 bits per channel
+__attribute__((target("avx2")))
+static inline __m256i blendWideAvx(__m256i dst, __m256i src, __m256i opacity) {
+    __m256i s = mulDiv255Avx(src, opacity);
+    __m256i alpha = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s, 0xff), 0xff);
+    __m256i inv = _mm256_sub_epi16(_mm256_set1_epi16(255), alpha);
+    return _mm256_add_epi16(s, mulDiv255Avx(dst, inv));
+}
+
+__attribute__((target("avx2")))
+static void blendAvx2(Uint32 *dst, const Uint32 *src, int count, Uint8 opacity) {
+    __m256i op = _mm256_set1_epi16(opacity);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i s0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        __m128i s1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i + 4));
+        __m128i d0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + i));
+        __m128i d1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + i + 4));
+
+        __m256i lo = blendWideAvx(_mm256_cvtepu8_epi16(d0), _mm256_cvtepu8_epi16(s0), op);
+        __m256i hi = blendWideAvx(_mm256_cvtepu8_epi16(d1), _mm256_cvtepu8_epi16(s1), op);
+        // the pack works per 128-bit lane: pixels come out as 0 1 4 5 2 3 6 7
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), 0xd8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), packed);
+    }
+    blendScalar(dst + i, src + i, count - i, opacity);
+}
+#endif // MYGUI_X86_SIMD
+
+#ifdef MYGUI_NEON_SIMD
+static inline uint8x8_t mulDiv255Neon(uint8x8_t a, uint8x8_t b) {
+    uint16x8_t t = vaddq_u16(vmull_u8(a, b), vdupq_n_u16(128));
+    return vshrn_n_u16(vaddq_u16(t, vshrq_n_u16(t, 8)), 8);
+}
+
+static void blendNeon(Uint32 *dst, const Uint32 *src, int count, Uint8 opacity) {
+    uint8x8_t op = vdup_n_u8(opacity);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        // planar B, G, R, A of eight pixels
+        uint8x8x4_t s = vld4_u8(reinterpret_cast<const uint8_t *>(src + i));
+        uint8x8x4_t d = vld4_u8(reinterpret_cast<const uint8_t *>(dst + i));
+
+        for (int c = 0; c < 4; c++) s.val[c] = mulDiv255Neon(s.val[c], op);
+        uint8x8_t inv = vmvn_u8(s.val[3]);
+        for (int c = 0; c < 4; c++) d.val[c] = vqadd_u8(s.val[c], mulDiv255Neon(d.val[c], inv));
+
+        vst4_u8(reinterpret_cast<uint8_t *>(dst + i), d);
+    }
+    blendScalar(dst + i, src + i, count - i, opacity);
+}
+#endif // MYGUI_NEON_SIMD
+
+SimdLevel detectSimdLevel() {
+#if defined(MYGUI_X86_SIMD)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return SimdLevel::AVX2;
+    if (__builtin_cpu_supports("sse4.1")) return SimdLevel::SSE41;
+#elif defined(MYGUI_NEON_SIMD)
+    return SimdLevel::NEON;
+#endif
+    return SimdLevel::SCALAR;
+}
+
+bool simdLevelSupported(SimdLevel level) {
+    switch (level) {
+    case SimdLevel::SCALAR: return true;
+#ifdef MYGUI_X86_SIMD
+    case SimdLevel::SSE41: return detectSimdLevel() != SimdLevel::SCALAR;
+    case SimdLevel::AVX2: return detectSimdLevel() == SimdLevel::AVX2;
+#endif
+#ifdef MYGUI_NEON_SIMD
+    case SimdLevel::NEON: return true;
+#endif
+    default: return false;
+    }
+}
+
+const char *simdLevelName(SimdLevel level) {
+    switch (level) {
+    case SimdLevel::SSE41: return "sse4.1";
+    case SimdLevel::AVX2: return "avx2";
+    case SimdLevel::NEON: return "neon";
+    default: return "scalar";
+    }
+}
+
+const CompositeKernels &compositeKernels(SimdLevel level) {
+    static const CompositeKernels scalar = {blendScalar};
+#ifdef MYGUI_X86_SIMD
+    static const CompositeKernels sse41 = {blendSse41};
+    static const CompositeKernels avx2 = {blendAvx2};
+    if (level == SimdLevel::AVX2 && simdLevelSupported(level)) return avx2;
+    if (level == SimdLevel::SSE41 && simdLevelSupported(level)) return sse41;
+#endif
+#ifdef MYGUI_NEON_SIMD
+    static const CompositeKernels neon = {blendNeon};
+    if (level == SimdLevel::NEON) return neon;
+#endif
+    return scalar;
+}
+
+void SoftImage::resize(int w, int h) {
+    width = w;
+    height = h;
+    pixels.assign(static_cast<std::size_t>(w) * h, 0);
+}
+
+SoftCompositor::SoftCompositor(int width, int height, SimdLevel level) {
+    frame_.resize(width, height);
+    setSimdLevel(level);
+}
+
+void SoftCompositor::setSimdLevel(SimdLevel level) {
+    level_ = simdLevelSupported(level) ? level : SimdLevel::SCALAR;
+    kernels_ = &compositeKernels(level_);
+}
+
+static inline Uint32 premultiply(SDL_Color color, Uint8 opacity) {
+    Uint32 alpha = mulDiv255(color.a, opacity);
+    return alpha << 24 | mulDiv255(color.r, alpha) << 16 | mulDiv255(color.g, alpha) << 8 | mulDiv255(color.b, alpha);
+}
+
+void SoftCompositor::fill(const SDL_Rect &area, SDL_Color color) {
+    Rect bounds(0, 0, frame_.width, frame_.height), visible;
+    if (!SDL_IntersectRect(&area, &bounds, &visible)) return;
+
+    Uint32 pixel = premultiply(color, 255);
+    for (int y = visible.y; y < visible.y + visible.h; y++) std::fill_n(frame_.row(y) + visible.x, visible.w, pixel);
+}
+
+void SoftCompositor::blendImage(const SoftImage &image, int x, int y, const SDL_Rect &area, Uint8 opacity) {
+    Rect placed(x, y, image.width, image.height), bounds(0, 0, frame_.width, frame_.height), visible;
+    if (!opacity) return;
+    if (!SDL_IntersectRect(&placed, &area, &visible)) return;
+    if (!SDL_IntersectRect(&visible, &bounds, &visible)) return;
+
+    for (int row = visible.y; row < visible.y + visible.h; row++) {
+        kernels_->blend(frame_.row(row) + visible.x, image.row(row - y) + (visible.x - x), visible.w, opacity);
+    }
+}
+
+void SoftCompositor::blendColor(const SDL_Rect &rect, const SDL_Rect &area, SDL_Color color, Uint8 opacity) {
+    Rect bounds(0, 0, frame_.width, frame_.height), visible;
+    if (!SDL_IntersectRect(&rect, &area, &visible)) return;
+    if (!SDL_IntersectRect(&visible, &bounds, &visible)) return;
+
+    Uint32 pixel = premultiply(color, opacity);
+    if (!pixel) return;
+
+    Uint32 span[COLOR_SPAN];
+    std::fill_n(span, COLOR_SPAN, pixel);
+
+    for (int row = visible.y; row < visible.y + visible.h; row++) {
+        Uint32 *dst = frame_.row(row) + visible.x;
+        for (int done = 0; done < visible.w; done += COLOR_SPAN) {
+            kernels_->blend(dst + done, span, std::min(COLOR_SPAN, visible.w - done), 255);
+        }
+    }
+}
+
+void SoftCompositor::upload(SDL_Texture *texture, const SDL_Rect &area) const {
+    assert(texture);
+
+    Rect bounds(0, 0, frame_.width, frame_.height), visible;
+    if (!SDL_IntersectRect(&area, &bounds, &visible)) return;
+
+    const Uint32 *pixels = frame_.row(visible.y) + visible.x;
+    SDL_UpdateTexture(texture, &visible, pixels, frame_.width * static_cast<int>(sizeof(Uint32)));
+}
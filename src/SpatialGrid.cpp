@@ -0,0 +1,56 @@
+#include <algorithm>
+#include <cassert>
+
+#include "SpatialGrid.h"
+
+SpatialGrid::SpatialGrid(int cellSize)
+    : cellSize_(cellSize)
+{
+    assert(cellSize_ > 0);
+}
+
+Uint64 SpatialGrid::cellKey(int cellX, int cellY) {
+    return (static_cast<Uint64>(static_cast<Uint32>(cellX)) << 32) | static_cast<Uint32>(cellY);
+}
+
+int SpatialGrid::cellCord(int cord) const {
+    // floor division, children may have negative local coordinates
+    return (cord >= 0) ? cord / cellSize_ : -((-cord - 1) / cellSize_) - 1;
+}
+
+void SpatialGrid::insert(Widget *widget, const SDL_Rect &rect) {
+    if (rect.w <= 0 || rect.h <= 0) return;
+
+    for (int cy = cellCord(rect.y); cy <= cellCord(rect.y + rect.h - 1); cy++) {
+        for (int cx = cellCord(rect.x); cx <= cellCord(rect.x + rect.w - 1); cx++) {
+            cells_[cellKey(cx, cy)].push_back(widget);
+        }
+    }
+}
+
+void SpatialGrid::remove(Widget *widget, const SDL_Rect &rect) {
+    if (rect.w <= 0 || rect.h <= 0) return;
+
+    for (int cy = cellCord(rect.y); cy <= cellCord(rect.y + rect.h - 1); cy++) {
+        for (int cx = cellCord(rect.x); cx <= cellCord(rect.x + rect.w - 1); cx++) {
+            auto cell = cells_.find(cellKey(cx, cy));
+            if (cell == cells_.end()) continue;
+
+            std::vector<Widget *> &widgets = cell->second;
+            widgets.erase(std::remove(widgets.begin(), widgets.end(), widget), widgets.end());
+            if (widgets.empty()) cells_.erase(cell);
+        }
+    }
+}
+
+void SpatialGrid::move(Widget *widget, const SDL_Rect &oldRect, const SDL_Rect &newRect) {
+    remove(widget, oldRect);
+    insert(widget, newRect);
+}
+
+const std::vector<Widget *> *SpatialGrid::candidates(int x, int y) const {
+    auto cell = cells_.find(cellKey(cellCord(x), cellCord(y)));
+    if (cell == cells_.end()) return nullptr;
+
+    return &cell->second;
+}
@@ -0,0 +1,88 @@
+#include <cassert>
+#include <functional>
+
+#include "TextTextureCache.h"
+#include "Common.h"
+
+std::size_t TextTextureCache::KeyHash::operator()(const Key &key) const {
+    std::size_t hash = std::hash<std::string>()(key.text);
+    hash ^= std::hash<const void *>()(key.font) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    hash ^= std::hash<Uint32>()(key.color)      + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    return hash;
+}
+
+TextTextureCache::TextTextureCache(SDL_Renderer *renderer, std::size_t budgetBytes)
+    : renderer_(renderer), budgetBytes_(budgetBytes)
+{
+    assert(renderer_);
+}
+
+TextTextureCache::~TextTextureCache() {
+    clear();
+}
+
+void TextTextureCache::clear() {
+    for (Entry &entry : lru_) SDL_DestroyTexture(entry.texture);
+    lru_.clear();
+    index_.clear();
+
+    stats_.bytes = 0;
+    stats_.entries = 0;
+}
+
+void TextTextureCache::resetCounters() {
+    stats_.hits = 0;
+    stats_.misses = 0;
+    stats_.evictions = 0;
+}
+
+void TextTextureCache::setBudget(std::size_t budgetBytes) {
+    budgetBytes_ = budgetBytes;
+    evict(0);
+}
+
+void TextTextureCache::evict(std::size_t incomingBytes) {
+    while (!lru_.empty() && stats_.bytes + incomingBytes > budgetBytes_) {
+        Entry &victim = lru_.back();
+        SDL_DestroyTexture(victim.texture);
+        stats_.bytes -= victim.bytes;
+        stats_.entries--;
+        stats_.evictions++;
+
+        index_.erase(victim.key);
+        lru_.pop_back();
+    }
+}
+
+SDL_Texture *TextTextureCache::get(TTF_Font *font, const char text[], SDL_Color color, SDL_Rect *size) {
+    assert(font);
+    assert(text);
+
+    Key key = {font, text, SDL2gfxColorToUint32(color)};
+
+    auto found = index_.find(key);
+    if (found != index_.end()) {
+        stats_.hits++;
+        lru_.splice(lru_.begin(), lru_, found->second);
+        if (size) *size = found->second->size;
+        return found->second->texture;
+    }
+
+    stats_.misses++;
+
+    SDL_Texture *texture = createFontTexture(font, text, color, renderer_);
+    SDL_Rect textureSize = {0, 0, 0, 0};
+    SDL_QueryTexture(texture, nullptr, nullptr, &textureSize.w, &textureSize.h);
+    std::size_t bytes = static_cast<std::size_t>(textureSize.w) * textureSize.h * 4;
+
+    // an entry larger than the whole budget is still cached alone, the caller needs the texture
+    evict(bytes);
+
+    lru_.push_front({key, texture, textureSize, bytes});
+    index_.emplace(std::move(key), lru_.begin());
+    stats_.bytes += bytes;
+    stats_.entries++;
+
+    if (size) *size = textureSize;
+    return texture;
+}
@@ -0,0 +1,80 @@
+#include <cassert>
+
+#include "TexturePool.h"
+
+TexturePool::TexturePool(SDL_Renderer *renderer, std::size_t budgetBytes)
+    : renderer_(renderer), budgetBytes_(budgetBytes)
+{
+    assert(renderer_);
+}
+
+TexturePool::~TexturePool() {
+    trim(0);
+}
+
+int TexturePool::sizeClass(int size) {
+    if (size < 1) size = 1;
+    return (size + TEXTURE_POOL_SIZE_STEP - 1) / TEXTURE_POOL_SIZE_STEP * TEXTURE_POOL_SIZE_STEP;
+}
+
+SDL_Texture *TexturePool::acquire(int w, int h) {
+    int classW = sizeClass(w);
+    int classH = sizeClass(h);
+
+    // most recently released first, its memory is the most likely to be resident
+    for (std::size_t i = free_.size(); i-- > 0; ) {
+        if (free_[i].w != classW || free_[i].h != classH) continue;
+
+        SDL_Texture *texture = free_[i].texture;
+        free_.erase(free_.begin() + i);
+        stats_.freeBytes -= textureBytes(classW, classH);
+        stats_.freeTextures--;
+        stats_.reuses++;
+        return texture;
+    }
+
+    SDL_Texture *texture = SDL_CreateTexture(renderer_, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, classW, classH);
+    if (!texture) {
+        SDL_Log("SDL_CreateTexture failed: %s", SDL_GetError());
+        return nullptr;
+    }
+    stats_.allocations++;
+    return texture;
+}
+
+void TexturePool::release(SDL_Texture *texture) {
+    if (!texture) return;
+
+    int w = 0, h = 0;
+    SDL_QueryTexture(texture, nullptr, nullptr, &w, &h);
+
+    // textures of foreign sizes are not reusable through acquire()
+    if (w != sizeClass(w) || h != sizeClass(h)) {
+        SDL_DestroyTexture(texture);
+        stats_.destroyed++;
+        return;
+    }
+
+    free_.push_back({texture, w, h});
+    stats_.freeBytes += textureBytes(w, h);
+    stats_.freeTextures++;
+
+    trim(budgetBytes_);
+}
+
+void TexturePool::trim(std::size_t budgetBytes) {
+    std::size_t evicted = 0;
+    while (evicted < free_.size() && stats_.freeBytes > budgetBytes) {
+        const FreeTexture &victim = free_[evicted++];
+        SDL_DestroyTexture(victim.texture);
+        stats_.freeBytes -= textureBytes(victim.w, victim.h);
+        stats_.freeTextures--;
+        stats_.destroyed++;
+    }
+    free_.erase(free_.begin(), free_.begin() + evicted);
+}
+
+void TexturePool::setBudget(std::size_t budgetBytes) {
+    budgetBytes_ = budgetBytes;
+    trim(budgetBytes_);
+}
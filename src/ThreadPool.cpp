@@ -0,0 +1,128 @@
+#include "ThreadPool.h"
+
+namespace {
+    // set for the worker threads of a pool
+    thread_local const ThreadPool *currentPool = nullptr;
+    thread_local std::size_t currentWorker = 0;
+}
+
+ThreadPool::ThreadPool(std::size_t threads) {
+    if (threads == 0) threads = std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+
+    for (std::size_t i = 0; i <= threads; i++) queues_.push_back(std::make_unique<TaskQueue>());
+
+    for (std::size_t i = 0; i < threads; i++) {
+        workers_.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    shutdown();
+}
+
+std::size_t ThreadPool::currentIndex() const {
+    return currentPool == this ? currentWorker : queues_.size() - 1;
+}
+
+void ThreadPool::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+
+    for (std::thread &worker : workers_) {
+        if (worker.joinable()) worker.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    TaskQueue &queue = *queues_[currentIndex()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+    }
+    queued_.fetch_add(1, std::memory_order_release);
+
+    // taken so a worker between its check and its wait can not miss the notification
+    { std::lock_guard<std::mutex> lock(sleepMutex_); }
+    cv_.notify_one();
+}
+
+bool ThreadPool::popBack(TaskQueue &queue, std::function<void()> &task) {
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) return false;
+
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    return true;
+}
+
+bool ThreadPool::popFront(TaskQueue &queue, std::function<void()> &task) {
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) return false;
+
+    task = std::move(queue.tasks.front());
+    queue.tasks.pop_front();
+    return true;
+}
+
+bool ThreadPool::takeTask(std::size_t index, std::function<void()> &task) {
+    if (!queued_.load(std::memory_order_acquire)) return false;
+
+    // own newest first (cache-warm), then the injection queue, then the oldest of the others
+    std::size_t injection = queues_.size() - 1;
+    bool taken = (index != injection && popBack(*queues_[index], task)) || popFront(*queues_[injection], task);
+    // every worker deque from the one after the caller's, a thread helping in
+    // TaskGroup::wait is no worker and starts at the first
+    std::size_t workers = injection;
+    std::size_t start = index < workers ? index + 1 : 0;
+    for (std::size_t i = 0; !taken && i < workers; i++) {
+        std::size_t victim = (start + i) % workers;
+        if (victim != index) taken = popFront(*queues_[victim], task);
+    }
+
+    if (taken) queued_.fetch_sub(1, std::memory_order_relaxed);
+    return taken;
+}
+
+bool ThreadPool::runPendingTask() {
+    std::function<void()> task;
+    if (!takeTask(currentIndex(), task)) return false;
+
+    task();
+    return true;
+}
+
+void ThreadPool::workerLoop(std::size_t index) {
+    currentPool = this;
+    currentWorker = index;
+
+    while (true) {
+        std::function<void()> task;
+        if (takeTask(index, task)) {
+            task();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex_);
+        cv_.wait(lock, [this] { return stopping_ || queued_.load(std::memory_order_acquire); });
+        if (stopping_ && !queued_.load(std::memory_order_acquire)) return; // stopping and drained
+    }
+}
+
+void TaskGroup::run(std::function<void()> task) {
+    pending_.fetch_add(1, std::memory_order_relaxed);
+    pool_.submit([this, task = std::move(task)] {
+        task();
+        pending_.fetch_sub(1, std::memory_order_acq_rel);
+    });
+}
+
+void TaskGroup::wait() {
+    // helping join: the waiting thread works instead of sleeping
+    while (pending_.load(std::memory_order_acquire)) {
+        if (!pool_.runPendingTask()) std::this_thread::yield();
+    }
+}
@@ -1,11 +1,13 @@
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 
 #include "UIManager.h"
 #include "Widget.h"
+#include "Profiler.h"
 
 UIManager::UIManager(int width, int height, Uint32 frameDelay)
-    : frameDelayMs_(frameDelay)
+    : frameDelayMs_(frameDelay), pacer_(frameDelay), screenDamage_(width, height)
 {
     mainWindow_ = SDL_CreateWindow(
         nullptr,
@@ -23,17 +25,137 @@ UIManager::UIManager(int width, int height, Uint32 frameDelay)
     }
 
     renderer_ = SDL_CreateRenderer(mainWindow_, -1, SDL_RENDERER_ACCELERATED);
-    SDL_SetRenderDrawBlendMode(renderer_, SDL_BLENDMODE_BLEND);
+    if (!renderer_) {
+        // headless machines (SDL_VIDEODRIVER=dummy) have no accelerated renderer
+        SDL_Log("SDL_CreateRenderer: %s, falling back to the software renderer", SDL_GetError());
+        renderer_ = SDL_CreateRenderer(mainWindow_, -1, SDL_RENDERER_SOFTWARE);
+    }
     assert(renderer_);
+    renderState_ = std::make_unique<RenderState>(renderer_);
+    renderState_->setBlendMode(SDL_BLENDMODE_BLEND);
+
+    glyphAtlas_ = std::make_unique<GlyphAtlas>(renderer_);
+    textTextureCache_ = std::make_unique<TextTextureCache>(renderer_);
+    assetManager_ = std::make_unique<AssetManager>(renderer_);
+    texturePool_ = std::make_unique<TexturePool>(renderer_);
+    renderBatch_ = std::make_unique<RenderBatch>(*renderState_);
+    animator_ = std::make_unique<Animator>();
+    scheduler_ = std::make_unique<Scheduler>(SDL_GetTicks64());
+    wakeEventType_ = SDL_RegisterEvents(1);
 }
 
 UIManager::~UIManager() {
+    // finished raster jobs post to this manager
+    rasterPool_.reset();
     if (wTreeRoot_) delete wTreeRoot_;
+    // modal widgets are owned by the user and may outlive the texture pool
+    for (Widget *modalWgt : modalWidgets_) modalWgt->attachUIManager(nullptr);
+    if (frameTexture_) SDL_DestroyTexture(frameTexture_);
+    if (softScratch_) SDL_DestroyTexture(softScratch_);
+    glyphAtlas_.reset();
+    textTextureCache_.reset();
+    assetManager_.reset();
+    texturePool_.reset();
+    renderBatch_.reset();
+    renderState_.reset();
+    animator_.reset();
+    scheduler_.reset();
+    updatePool_.reset();
     if (mainWindow_) SDL_DestroyWindow(mainWindow_);
     if (renderer_) SDL_DestroyRenderer(renderer_);
     SDL_Quit();
 }
 
+ThreadPool &UIManager::updatePool() {
+    std::call_once(updatePoolOnce_, [this] {
+        // the updating thread helps while it waits
+        unsigned threads = std::thread::hardware_concurrency();
+        updatePool_ = std::make_unique<ThreadPool>(threads > 1 ? threads - 1 : 1);
+    });
+    return *updatePool_;
+}
+
+ThreadPool &UIManager::rasterPool() {
+    std::call_once(rasterPoolOnce_, [this] {
+        unsigned threads = std::thread::hardware_concurrency();
+        rasterPool_ = std::make_unique<ThreadPool>(threads > 1 ? threads - 1 : 1);
+    });
+    return *rasterPool_;
+}
+
+bool UIManager::setVSync(bool vsync) {
+    if (SDL_RenderSetVSync(renderer_, vsync ? 1 : 0) != 0) {
+        SDL_Log("SDL_RenderSetVSync: %s", SDL_GetError());
+        return false;
+    }
+
+    // the vblank interval tells a blocked present from a missed one
+    SDL_DisplayMode mode = {};
+    double refreshMs = 0;
+    if (SDL_GetWindowDisplayMode(mainWindow_, &mode) == 0 && mode.refresh_rate > 0) refreshMs = 1000.0 / mode.refresh_rate;
+
+    pacer_.setVSync(vsync, refreshMs);
+    return true;
+}
+
+void UIManager::wake() {
+    // one wake event per drain is enough
+    if (wakePending_.exchange(true, std::memory_order_acq_rel)) return;
+    if (wakeEventType_ == (Uint32)-1) return;
+
+    SDL_Event wakeEvent = {};
+    wakeEvent.type = wakeEventType_;
+    SDL_PushEvent(&wakeEvent);
+}
+
+void UIManager::post(std::function<void()> closure) {
+    assert(closure);
+
+    PostedMessage message;
+    message.closure = std::move(closure);
+    posted_.push(std::move(message));
+    wake();
+}
+
+void UIManager::postInvalidate(Widget *widget) {
+    assert(widget);
+
+    PostedMessage message;
+    message.widget = widget;
+    posted_.push(std::move(message));
+    wake();
+}
+
+bool UIManager::drainPosted() {
+    // cleared first: a post racing with the drain wakes the loop again
+    wakePending_.store(false, std::memory_order_release);
+
+    // taken out first: what the closures post waits for the next frame instead of being
+    // popped by this loop, a closure re-posting itself would never let it end
+    PostedMessage message;
+    while (posted_.pop(message)) postedBatch_.push_back(std::move(message));
+    bool drained = !postedBatch_.empty();
+
+    for (PostedMessage &posted : postedBatch_) {
+        if (posted.closure) posted.closure();
+        if (posted.widget) postedInvalidations_.push_back(posted.widget);
+    }
+    postedBatch_.clear();
+
+    std::sort(postedInvalidations_.begin(), postedInvalidations_.end());
+    auto last = std::unique(postedInvalidations_.begin(), postedInvalidations_.end());
+    for (auto it = postedInvalidations_.begin(); it != last; ++it) (*it)->invalidate();
+    postedInvalidations_.clear();
+
+    return drained;
+}
+
+TimerHandle UIManager::addUserEvent(std::function<void(int)> userEvent) {
+    return scheduler_->every(frameDelayMs_, [userEvent = std::move(userEvent)](Uint32 deltaMs) {
+        userEvent(static_cast<int>(deltaMs));
+    });
+}
+
 TTF_Font* UIManager::createFont(const char fontPath[], const size_t fontSize) {
     assert(fontPath);
 
@@ -53,53 +175,235 @@ void UIManager::setMainWidget(int x, int y, Widget *mainWidget) {
     }
     mainWidget->setPosition(x, y);
     wTreeRoot_ = mainWidget;
+    initWTree(wTreeRoot_);
+    damageScreen();
 }
 
-void UIManager::globalStateOnMouseMove(Widget *wgt, const MouseMotionEvent &event) {
-    if (!isInsideRect(wgt->rect(), event.pos.x, event.pos.y)) return;
-    
-    if (event.button == SDL_BUTTON_LEFT) glState_.hovered = wgt;
-    
-    for (auto it = wgt->getChildren().rbegin(); it != wgt->getChildren().rend(); ++it) {
-        MouseMotionEvent childLocal = event;
-        childLocal.pos.x -= wgt->rect().x;
-        childLocal.pos.y -= wgt->rect().y;
+void UIManager::pushModalWidget(int x, int y, Widget *modalWidget) {
+    assert(modalWidget);
+
+    modalWidget->setPosition(x, y);
+    modalWidgets_.push_back(modalWidget);
+    initWTree(modalWidget);
+
+    Rect modalRect = modalWidget->rect();
+    damageScreen(&modalRect);
+}
+
+void UIManager::damageScreen(const SDL_Rect *rect) {
+    if (rect) screenDamage_.add(*rect);
+    else screenDamage_.addFull();
+}
+
+namespace {
+
+// either side of a modifier counts, lock keys are ignored
+Uint64 hotkeyCombo(int sym, int keymod) {
+    Uint16 mods = 0;
+    if (keymod & KMOD_CTRL)  mods |= KMOD_CTRL;
+    if (keymod & KMOD_SHIFT) mods |= KMOD_SHIFT;
+    if (keymod & KMOD_ALT)   mods |= KMOD_ALT;
+    if (keymod & KMOD_GUI)   mods |= KMOD_GUI;
+
+    return (static_cast<Uint64>(mods) << 32) | static_cast<Uint32>(sym);
+}
+
+bool isModifierKey(int sym) {
+    return sym >= SDLK_LCTRL && sym <= SDLK_RGUI;
+}
+
+} // namespace
+
+void UIManager::registerHotkey(SDL_KeyCode hotkey, std::function<void()> action) {
+    registerHotkey(hotkey, KMOD_NONE, std::move(action));
+}
+
+void UIManager::registerHotkey(SDL_KeyCode hotkey, Uint16 mods, std::function<void()> action) {
+    assert(action);
+
+    hotkeys_[hotkeyCombo(hotkey, mods)] = std::move(action);
+}
+
+void UIManager::registerHotkeyChord(SDL_KeyCode first, Uint16 firstMods, SDL_KeyCode second, Uint16 secondMods,
+                                    std::function<void()> action) {
+    assert(action);
+
+    chords_[hotkeyCombo(first, firstMods)][hotkeyCombo(second, secondMods)] = std::move(action);
+}
+
+void UIManager::unregisterHotkey(SDL_KeyCode hotkey, Uint16 mods) {
+    hotkeys_.erase(hotkeyCombo(hotkey, mods));
+}
 
-        globalStateOnMouseMove(*it, childLocal);
+bool UIManager::runHotkey(const KeyEvent &event) {
+    if (hotkeys_.empty() && chords_.empty()) return false;
+    // pressing Ctrl on the way to Ctrl+C neither matches nor breaks a chord
+    if (isModifierKey(event.sym)) return false;
+
+    Uint64 combo = hotkeyCombo(event.sym, event.keymod);
+    std::function<void()> action;
+
+    if (chordPrefix_) {
+        auto chord = chords_.find(chordPrefix_);
+        bool inTime = SDL_GetTicks64() - chordStartMs_ <= DEFAULT_CHORD_TIMEOUT_MS;
+        chordPrefix_ = 0;
+
+        if (inTime && chord != chords_.end()) {
+            auto it = chord->second.find(combo);
+            if (it != chord->second.end()) action = it->second;
+        }
+        // otherwise the key is handled like any other
     }
+
+    if (!action) {
+        if (chords_.count(combo)) {
+            chordPrefix_ = combo;
+            chordStartMs_ = SDL_GetTicks64();
+            return true;
+        }
+
+        auto it = hotkeys_.find(combo);
+        if (it == hotkeys_.end()) return false;
+        action = it->second;
+    }
+
+    // a copy, the action may register or unregister hotkeys
+    action();
+    return true;
 }
 
-void UIManager::globalStateOnKeyDown(Widget *wgt, const KeyEvent &event) {    
-    return;
+void UIManager::collectFocusable(Widget *wgt) {
+    if (wgt->isFocusable()) focusChain_.push_back(wgt);
+    for (Widget *child : wgt->getChildren()) collectFocusable(child);
 }
 
-void UIManager::globalStateOnKeyUp(Widget *wgt, const KeyEvent &event) {    
-    return;
+void UIManager::rebuildFocusChain() {
+    focusChain_.clear();
+
+    if (wTreeRoot_) collectFocusable(wTreeRoot_);
+    for (Widget *modalWgt : modalWidgets_) collectFocusable(modalWgt);
+
+    std::stable_sort(focusChain_.begin(), focusChain_.end(), [](const Widget *a, const Widget *b) {
+        return a->tabIndex() < b->tabIndex();
+    });
+    focusChainDirty_ = false;
 }
 
-void UIManager::globalStateOnMouseWheel(Widget *wgt, const MouseWheelEvent &event) {    
-    return;
+// focusable, attached here and neither it nor an ancestor hidden
+bool UIManager::focusReachable(const Widget *wgt) const {
+    if (!wgt->isFocusable() || wgt->UIManager_ != this) return false;
+
+    for (const Widget *ancestor = wgt; ancestor; ancestor = ancestor->parent_) {
+        if (ancestor->isHiden()) return false;
+    }
+    return true;
 }
 
-void UIManager::globalStateOnMouseDown(Widget *wgt, const MouseButtonEvent &event) {
-    if (!isInsideRect(wgt->rect(), event.pos.x, event.pos.y)) return;
-    
-    if (event.button == SDL_BUTTON_LEFT) glState_.mouseActived = wgt;
-    
-    for (auto it = wgt->getChildren().rbegin(); it != wgt->getChildren().rend(); ++it) {
-        MouseButtonEvent childLocal = event;
-        childLocal.pos.x -= wgt->rect().x;
-        childLocal.pos.y -= wgt->rect().y;
+void UIManager::setFocus(Widget *widget) {
+    if (widget == glState_.focused) return;
+    if (widget && !focusReachable(widget)) {
+        std::cerr << "setFocus failed : widget is not focusable\n";
+        return;
+    }
+
+    Widget *previous = glState_.focused;
+    glState_.focused = widget;
+    if (previous) previous->onFocusSelfAction(false);
+    if (widget) widget->onFocusSelfAction(true);
+}
+
+bool UIManager::focusNext(bool backward) {
+    if (focusChainDirty_) rebuildFocusChain();
+    if (focusChain_.empty()) return false;
+
+    std::size_t count = focusChain_.size();
+    Widget *focus = glState_.focused;
+    if (focus && (focusIndex_ >= count || focusChain_[focusIndex_] != focus)) {
+        auto it = std::find(focusChain_.begin(), focusChain_.end(), focus);
+        focus = it != focusChain_.end() ? focus : nullptr;
+        focusIndex_ = it - focusChain_.begin();
+    }
 
-        globalStateOnMouseDown(*it, childLocal);
+    // without focus Tab starts at the first widget and Shift+Tab at the last
+    std::size_t start = focus ? focusIndex_ : (backward ? 0 : count - 1);
+    for (std::size_t step = 1; step <= count; step++) {
+        std::size_t index = backward ? (start + count - step) % count : (start + step) % count;
+        if (!focusReachable(focusChain_[index])) continue;
+
+        focusIndex_ = index;
+        setFocus(focusChain_[index]);
+        return true;
+    }
+
+    return false;
+}
+
+bool UIManager::focusInModal(const Widget *wgt) const {
+    while (wgt->parent_) wgt = wgt->parent_;
+    return std::find(modalWidgets_.begin(), modalWidgets_.end(), wgt) != modalWidgets_.end();
+}
+
+void UIManager::focusOnPress() {
+    const std::vector<HitPathEntry> &path = pointerDispatcher_.path();
+    for (auto it = path.rbegin(); it != path.rend(); ++it) {
+        if (!it->widget->isFocusable()) continue;
+
+        setFocus(it->widget);
+        return;
     }
 }
 
+void UIManager::dispatchKeyDown(const KeyEvent &event) {
+    if (runHotkey(event)) return;
 
+    Widget *focus = glState_.focused;
+    if (focus && !focusReachable(focus)) {
+        setFocus(nullptr);
+        focus = nullptr;
+    }
+
+    // visible modals sit above the main tree, they see the keys before a focus outside them
+    if (!(focus && focusInModal(focus)) && modalWidgetsOnKeyDown(event) == CONSUME) return;
+
+    if (focus) {
+        for (Widget *wgt = focus; wgt; wgt = wgt->parent_) {
+            if (wgt->onKeyDown(event) == CONSUME) return;
+        }
+    }
+    else if (glState_.mouseActived && glState_.mouseActived->onKeyDown(event) == CONSUME) return;
+
+    if (event.sym == SDLK_TAB && !(event.keymod & (KMOD_CTRL | KMOD_ALT | KMOD_GUI))) {
+        focusNext(event.keymod & KMOD_SHIFT);
+    }
+}
+
+void UIManager::dispatchKeyUp(const KeyEvent &event) {
+    Widget *focus = glState_.focused;
+    if (focus && !focusReachable(focus)) focus = nullptr;
+
+    if (!(focus && focusInModal(focus)) && modalWidgetsOnKeyUp(event) == CONSUME) return;
+
+    if (focus) {
+        for (Widget *wgt = focus; wgt; wgt = wgt->parent_) {
+            if (wgt->onKeyUp(event) == CONSUME) return;
+        }
+    }
+    else if (glState_.mouseActived) glState_.mouseActived->onKeyUp(event);
+}
+
+void UIManager::globalStateOnMouseWheel(Widget *wgt, const MouseWheelEvent &event) {    
+    return;
+}
+
+// modal widgets go through the same dispatch as the main tree, one hit path per modal
 bool UIManager::modalWidgetsOnMouseMove(const MouseMotionEvent &event) {
     for (Widget *modalWgt : modalWidgets_) {
         if (modalWgt->isHiden()) continue;
-        if (modalWgt->onMouseMove(event) == CONSUME) return CONSUME;
+
+        hitTestTop(modalWgt, event.pos);
+        if (!pointerDispatcher_.target()) continue;
+        if (event.button == SDL_BUTTON_LEFT) glState_.hovered = pointerDispatcher_.target();
+        if (pointerDispatcher_.mouseMove(event) == CONSUME) return CONSUME;
     }
 
     return PROPAGATE;
@@ -135,7 +439,12 @@ bool UIManager::modalWidgetsOnMouseWheel(const MouseWheelEvent &event) {
 bool UIManager::modalWidgetsOnMouseDown(const MouseButtonEvent &event) {
     for (Widget *modalWgt : modalWidgets_) {
         if (modalWgt->isHiden()) continue;
-        if (modalWgt->onMouseDown(event) == CONSUME) return CONSUME;
+
+        hitTestTop(modalWgt, event.pos);
+        if (!pointerDispatcher_.target()) continue;
+        if (event.button == SDL_BUTTON_LEFT) setMouseActived(pointerDispatcher_.target());
+        focusOnPress();
+        if (pointerDispatcher_.mouseDown(event) == CONSUME) return CONSUME;
     }
     return PROPAGATE;
 }
@@ -143,54 +452,141 @@ bool UIManager::modalWidgetsOnMouseDown(const MouseButtonEvent &event) {
 bool UIManager::modalWidgetsOnMouseUp(const MouseButtonEvent &event) {
     for (Widget *modalWgt : modalWidgets_) {
         if (modalWgt->isHiden()) continue;
-        if (modalWgt->onMouseUp(event) == CONSUME) return CONSUME;
+
+        hitTestTop(modalWgt, event.pos);
+        if (!pointerDispatcher_.target()) continue;
+        if (pointerDispatcher_.mouseUp(event) == CONSUME) return CONSUME;
     }
     return PROPAGATE;
 }
 
 
-void UIManager::handleSDLEvents(bool *running) {
-   
-    static gm_dot<int, 2> prevMousePos = {0, 0};
-    gm_dot<int, 2> curMousePos = {0, 0};
+void UIManager::setMouseActived(Widget *widget) {
+    if (widget != glState_.mouseActived) glState_.pointerCaptured = false;
+    glState_.mouseActived = widget;
+}
+
+void UIManager::capturePointer(Widget *widget, Uint8 button) {
+    assert(widget);
+
+    glState_.mouseActived = widget;
+    glState_.pointerCaptured = true;
+    glState_.captureButton = button;
+}
+
+// the screen position of the coordinate space wgt's events are delivered in
+gm_dot<int, 2> UIManager::parentOrigin(const Widget *wgt) const {
+    gm_dot<int, 2> origin = {0, 0};
+    for (const Widget *ancestor = wgt->parent(); ancestor; ancestor = ancestor->parent()) {
+        Rect ancestorRect = ancestor->rect();
+        origin.x += ancestorRect.x;
+        origin.y += ancestorRect.y;
+    }
+
+    return origin;
+}
+
+Widget *UIManager::capturedWidget() {
+    if (!glState_.pointerCaptured) return nullptr;
+
+    // a hidden widget cannot keep the pointer
+    if (glState_.mouseActived->isHiden()) {
+        glState_.pointerCaptured = false;
+        return nullptr;
+    }
 
+    return glState_.mouseActived;
+}
+
+void UIManager::forgetWidget(const Widget *wgt) {
+    if (wgt->isFocusable()) focusChainChanged();
+    if (glState_.focused == wgt) glState_.focused = nullptr;
+    if (glState_.hovered == wgt) glState_.hovered = nullptr;
+    if (glState_.mouseActived == wgt) {
+        glState_.mouseActived = nullptr;
+        glState_.pointerCaptured = false;
+    }
+}
+
+void UIManager::dispatchMouseMove(const MouseMotionEvent &event) {
+    if (Widget *capture = capturedWidget()) {
+        gm_dot<int, 2> origin = parentOrigin(capture);
+        MouseMotionEvent local = event;
+        local.pos.x -= origin.x;
+        local.pos.y -= origin.y;
+        capture->onMouseMoveSelfAction(local);
+        return;
+    }
+
+    if (modalWidgetsOnMouseMove(event) == CONSUME) return;
+    if (!wTreeRoot_) return;
+
+    hitTestTop(wTreeRoot_, event.pos);
+    if (event.button == SDL_BUTTON_LEFT && pointerDispatcher_.target()) glState_.hovered = pointerDispatcher_.target();
+    pointerDispatcher_.mouseMove(event);
+}
+
+bool UIManager::rawMouseMotionWanted() const {
+    if (rawMouseMotion_) return true;
+    if (glState_.mouseActived && glState_.mouseActived->rawMouseMotion()) return true;
+    if (glState_.hovered && glState_.hovered->rawMouseMotion()) return true;
+    return false;
+}
+
+// consecutive motion events with the same button state are folded into one
+void UIManager::foldMouseMotion(const SDL_MouseMotionEvent &sdlMotion, MouseMotionEvent &motion, bool &pending) {
+    Uint8 buttons = static_cast<Uint8>(sdlMotion.state);
+
+    if (pending && motion.button == buttons) {
+        motion.pos = {sdlMotion.x, sdlMotion.y};
+        motion.rel += gm_dot<int, 2>(sdlMotion.xrel, sdlMotion.yrel);
+    } else {
+        if (pending) dispatchMouseMove(motion);
+        motion = MouseMotionEvent(sdlMotion.x, sdlMotion.y, buttons, sdlMotion.xrel, sdlMotion.yrel);
+    }
+    pending = true;
+
+    if (rawMouseMotionWanted()) {
+        dispatchMouseMove(motion);
+        pending = false;
+    }
+}
+
+void UIManager::handleSDLEvents(bool *running) {
     SDL_Event SDLEvent = {};
     MouseButtonEvent mouseButtonEvent = {};
     MouseMotionEvent mouseMotionEvent = {};
     MouseWheelEvent  mouseWheelEvent  = {};
     KeyEvent         keyEvent         = {};
+
+    bool motionPending = false;
     
     while (SDL_PollEvent(&SDLEvent)) {
         if (SDLEvent.type == SDL_QUIT || SDLEvent.type == SDL_KEYDOWN && SDLEvent.key.keysym.sym == SDLK_ESCAPE) {
             *running = false;
-            break;
+            return;
+        }
+
+        if (SDLEvent.type == SDL_MOUSEMOTION) {
+            foldMouseMotion(SDLEvent.motion, mouseMotionEvent, motionPending);
+            continue;
+        }
+
+        // any other transition is ordered after the motion that preceded it
+        if (motionPending) {
+            dispatchMouseMove(mouseMotionEvent);
+            motionPending = false;
         }
 
         switch (SDLEvent.type) {
             case SDL_KEYDOWN:
                 keyEvent = KeyEvent(SDLEvent.key.keysym.sym, SDLEvent.key.keysym.mod);
-                
-                if (modalWidgetsOnKeyDown(keyEvent) == CONSUME) break;
-                if (wTreeRoot_) globalStateOnKeyDown(wTreeRoot_, keyEvent);
-                if (glState_.mouseActived) glState_.mouseActived->onKeyDown(keyEvent);
+                dispatchKeyDown(keyEvent);
                 break;
             
             case SDL_KEYUP:
                 keyEvent = KeyEvent(SDLEvent.key.keysym.sym, SDLEvent.key.keysym.mod);
-
-                if (modalWidgetsOnKeyUp(keyEvent) == CONSUME) break;
-                if (wTreeRoot_) globalStateOnKeyDown(wTreeRoot_, keyEvent);
-                if (glState_.mouseActived) glState_.mouseActived->onKeyUp(keyEvent);
-                break;
-
-            case SDL_MOUSEMOTION:
-                SDL_GetMouseState(&curMousePos.x, &curMousePos.y);
-                mouseMotionEvent = MouseMotionEvent(curMousePos.x, curMousePos.y, SDLEvent.button.button, 
-                                    curMousePos.x - prevMousePos.x, curMousePos.y - prevMousePos.y);
-                
-                if (modalWidgetsOnMouseMove(mouseMotionEvent) == CONSUME) break;
-                if (wTreeRoot_) globalStateOnMouseMove(wTreeRoot_, mouseMotionEvent);
-                if (wTreeRoot_) wTreeRoot_->onMouseMove(mouseMotionEvent);
+                dispatchKeyUp(keyEvent);
                 break;
             
             case SDL_MOUSEWHEEL:
@@ -205,60 +601,362 @@ void UIManager::handleSDLEvents(bool *running) {
                 mouseButtonEvent = MouseButtonEvent(SDLEvent.button.x, SDLEvent.button.y, SDLEvent.button.button);
                 
                 if (modalWidgetsOnMouseDown(mouseButtonEvent) == CONSUME) break;
-                if (wTreeRoot_) globalStateOnMouseDown(wTreeRoot_, mouseButtonEvent);
-                if (wTreeRoot_) wTreeRoot_->onMouseDown(mouseButtonEvent);
+                if (!wTreeRoot_) break;
+
+                hitTestTop(wTreeRoot_, mouseButtonEvent.pos);
+                if (mouseButtonEvent.button == SDL_BUTTON_LEFT && pointerDispatcher_.target()) 
+                    setMouseActived(pointerDispatcher_.target());
+                focusOnPress();
+                pointerDispatcher_.mouseDown(mouseButtonEvent);
                 break;
     
             case SDL_MOUSEBUTTONUP:
                 mouseButtonEvent = MouseButtonEvent(SDLEvent.button.x, SDLEvent.button.y, SDLEvent.button.button);
 
+                // released before the handler runs, which may capture again
+                if (Widget *capture = capturedWidget(); capture && mouseButtonEvent.button == glState_.captureButton) {
+                    glState_.pointerCaptured = false;
+                    gm_dot<int, 2> origin = parentOrigin(capture);
+                    mouseButtonEvent.pos.x -= origin.x;
+                    mouseButtonEvent.pos.y -= origin.y;
+                    capture->onMouseUpSelfAction(mouseButtonEvent);
+                    break;
+                }
+
                 if (modalWidgetsOnMouseUp(mouseButtonEvent) == CONSUME) break;
-                if (wTreeRoot_) wTreeRoot_->onMouseUp(mouseButtonEvent);
+                if (!wTreeRoot_) break;
+
+                hitTestTop(wTreeRoot_, mouseButtonEvent.pos);
+                pointerDispatcher_.mouseUp(mouseButtonEvent);
+                break;
+
+            case SDL_WINDOWEVENT:
+                if (SDLEvent.window.event == SDL_WINDOWEVENT_EXPOSED || 
+                    SDLEvent.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) damageScreen();
                 break;
             
             default:
                 break;
         }
-        SDL_GetMouseState(&prevMousePos.x, &prevMousePos.y);
     }
+
+    if (motionPending) dispatchMouseMove(mouseMotionEvent);
+}
+
+bool UIManager::latchPointer() {
+    SDL_PumpEvents();
+
+    // buttons, keys and quit must not be overtaken by the motion queued after them
+    if (SDL_HasEvent(SDL_QUIT) || SDL_HasEvents(SDL_KEYDOWN, SDL_MOUSEMOTION - 1) ||
+        SDL_HasEvents(SDL_MOUSEMOTION + 1, SDL_MOUSEWHEEL)) return false;
+
+    SDL_Event events[64];
+    MouseMotionEvent mouseMotionEvent = {};
+    bool motionPending = false;
+    bool latched = false;
+
+    latching_ = true;
+    int count;
+    while ((count = SDL_PeepEvents(events, 64, SDL_GETEVENT, SDL_MOUSEMOTION, SDL_MOUSEMOTION)) > 0) {
+        for (int i = 0; i < count; i++) foldMouseMotion(events[i].motion, mouseMotionEvent, motionPending);
+        latched = true;
+    }
+
+    if (motionPending) dispatchMouseMove(mouseMotionEvent);
+    latching_ = false;
+    return latched;
 }
 
 void UIManager::initWTree(Widget *wgt) {
     assert(wgt);
 
-    wgt->UIManager_ = this;
-    for (Widget * child : wgt->getChildren()) {
-        initWTree(child);
+    wgt->attachUIManager(this);
+}
+
+bool UIManager::updatePass() {
+    bool updated = false;
+    if (wTreeRoot_ && wTreeRoot_->needsUpdate()) updated |= wTreeRoot_->update();
+
+    for (Widget *modalWgt : modalWidgets_) {
+        if (modalWgt->needsUpdate()) updated |= modalWgt->update();
     }
+
+    updated |= scheduler_->advance(SDL_GetTicks64()) > 0;
+    updated |= animator_->update(SDL_GetTicks());
+
+    return updated;
 }
 
-void UIManager::updatePass() {
-    if (wTreeRoot_) wTreeRoot_->update();
+bool UIManager::needsPresent() const {
+    if (!screenDamage_.empty() || !frameTexture_) return true;
+    if (wTreeRoot_ && wTreeRoot_->needRerender()) return true;
 
     for (Widget *modalWgt : modalWidgets_) {
-        modalWgt->update();
+        if (!modalWgt->isHiden() && modalWgt->needRerender()) return true;
     }
 
-    for (std::function<void(int)> userEvent : userEvents_)
-        userEvent(frameDelayMs_);
+    return false;
 }
 
-void UIManager::renderPass() {
+void UIManager::collectLayers(Widget *top, Widget *wgt) {
+    if (wgt != top && wgt->isLayer()) layers_.push_back({top, wgt});
+
+    // paint order, children_[0] is the topmost
+    const std::vector<Widget *> &children = wgt->getChildren();
+    for (auto it = children.rbegin(); it != children.rend(); ++it) collectLayers(top, *it);
+}
+
+void UIManager::rebuildLayers() {
+    layers_.clear();
+
+    auto collectTop = [this](Widget *top) {
+        std::size_t first = layers_.size();
+        collectLayers(top, top);
+        std::stable_sort(layers_.begin() + first, layers_.end(), [](const LayerEntry &a, const LayerEntry &b) {
+            return a.layer->zOrder() < b.layer->zOrder();
+        });
+    };
+
+    if (wTreeRoot_) collectTop(wTreeRoot_);
+    for (Widget *modalWgt : modalWidgets_) collectTop(modalWgt);
+
+    // mirrors of widgets that are no longer layers (or destroyed)
+    for (auto it = softPlanes_.begin(); it != softPlanes_.end();) {
+        bool isTop = it->first == wTreeRoot_
+                  || std::find(modalWidgets_.begin(), modalWidgets_.end(), it->first) != modalWidgets_.end();
+        bool isLayer = std::any_of(layers_.begin(), layers_.end(), [&](const LayerEntry &entry) { return entry.layer == it->first; });
+        if (isTop || isLayer) ++it;
+        else it = softPlanes_.erase(it);
+    }
+
+    layersDirty_ = false;
+}
+
+void UIManager::compositeLayers(Widget *top, const SDL_Rect &area) {
+    for (const LayerEntry &entry : layers_) {
+        if (entry.top != top) continue;
+
+        SDL_Rect dst, clip, visible;
+        if (!entry.layer->screenPlacement(dst, clip)) continue;
+        if (!SDL_IntersectRect(&clip, &area, &visible)) continue;
+
+        bool narrowed = !SDL_RectEquals(&visible, &dst);
+        if (narrowed) {
+            renderBatch_->flush();
+            renderState_->setClipRect(&visible);
+        }
+
+        entry.layer->composeInto(renderer_, *renderBatch_, dst, narrowed ? visible : area);
+
+        if (narrowed) {
+            renderBatch_->flush();
+            renderState_->setClipRect(&area);
+        }
+    }
+}
+
+void UIManager::hitTestTop(Widget *top, const gm_dot<int, 2> &pos) {
+    if (layersDirty_) rebuildLayers();
+
+    for (auto it = layers_.rbegin(); it != layers_.rend(); ++it) {
+        if (it->top != top) continue;
+
+        SDL_Rect dst, clip;
+        if (!it->layer->screenPlacement(dst, clip)) continue;
+        if (!isInsideRect(clip, pos.x, pos.y)) continue;
+
+        pointerDispatcher_.hitTestLayer(it->layer, pos);
+        return;
+    }
+
+    pointerDispatcher_.hitTest(top, pos);
+}
+
+void UIManager::compositeScreenArea(const SDL_Rect &area) {
+    renderState_->setClipRect(&area);
+    renderBatch_->fillRect(area, DEFAULT_BACKGROUND_COLOR);
+
     if (wTreeRoot_) {
-        wTreeRoot_->render(renderer_);
-        SDL_Rect dst = wTreeRoot_->rect();
-        SDL_RenderCopy(renderer_, wTreeRoot_->texture(), NULL, &dst);
+        wTreeRoot_->composeInto(renderer_, *renderBatch_, wTreeRoot_->rect(), area);
+        compositeLayers(wTreeRoot_, area);
     }
 
     for (Widget *modalWgt : modalWidgets_)  {
         if (modalWgt->isHiden()) continue;
+        modalWgt->composeInto(renderer_, *renderBatch_, modalWgt->rect(), area);
+        compositeLayers(modalWgt, area);
+    }
 
-        modalWgt->render(renderer_);
-        assert(modalWgt->texture());
-    
-        SDL_Rect dst = modalWgt->rect();
-        SDL_RenderCopy(renderer_, modalWgt->texture(), NULL, &dst);
+    renderBatch_->flush();
+}
+
+void UIManager::renderPlane(Widget *wgt) {
+    if (!softCompositor_) {
+        wgt->render(renderer_);
+        return;
+    }
+
+    // what render() is about to redraw, in local coordinates
+    SoftPlane &plane = softPlanes_[wgt];
+    Rect full(0, 0, wgt->rect().w, wgt->rect().h), dirty;
+    bool stale = !plane.valid || plane.image.width != full.w || plane.image.height != full.h
+              || (plane.baked && plane.bakedOpacity != wgt->opacity());
+
+    if (stale || wgt->damage().isFull()) dirty = full;
+    else if (wgt->needRerender()) dirty = wgt->damage().boundingRect();
+
+    wgt->render(renderer_);
+
+    if (stale) plane.image.resize(full.w, full.h);
+    if (stale || !SDL_RectEmpty(&dirty)) refreshSoftPlane(wgt, plane, dirty);
+}
+
+void UIManager::refreshSoftPlane(Widget *wgt, SoftPlane &plane, const SDL_Rect &dirty) {
+    plane.valid = true;
+    plane.solid = wgt->isSolidLeaf(plane.color);
+    plane.baked = false;
+    if (plane.solid || SDL_RectEmpty(&dirty)) return;
+
+    RenderStateScope stateScope(*renderState_);
+    Uint32 *pixels = plane.image.row(dirty.y) + dirty.x;
+    int pitch = plane.image.width * static_cast<int>(sizeof(Uint32));
+
+    if (wgt->keepsTexture()) {
+        // the widget's own target, its opacity is applied when compositing
+        if (!wgt->texture()) return;
+        renderState_->setTarget(wgt->texture());
+        renderState_->setViewport(nullptr);
+        renderState_->apply();
+        SDL_RenderReadPixels(renderer_, &dirty, SDL_PIXELFORMAT_ARGB8888, pixels, pitch);
+        return;
+    }
+
+    // direct top: composed over transparent black, which leaves premultiplied pixels
+    int scratchW = 0, scratchH = 0;
+    if (softScratch_) SDL_QueryTexture(softScratch_, nullptr, nullptr, &scratchW, &scratchH);
+    if (scratchW < plane.image.width || scratchH < plane.image.height) {
+        if (softScratch_) SDL_DestroyTexture(softScratch_);
+        softScratch_ = SDL_CreateTexture(renderer_, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET,
+                                         std::max(scratchW, plane.image.width), std::max(scratchH, plane.image.height));
+        assert(softScratch_);
     }
+
+    renderState_->setTarget(softScratch_);
+    renderState_->setViewport(nullptr);
+    renderState_->setClipRect(&dirty);
+    renderState_->clearRect(dirty);
+
+    wgt->composeInto(renderer_, *renderBatch_, Rect(0, 0, plane.image.width, plane.image.height), dirty);
+    renderBatch_->flush();
+    renderState_->apply();
+    SDL_RenderReadPixels(renderer_, &dirty, SDL_PIXELFORMAT_ARGB8888, pixels, pitch);
+
+    plane.baked = true;
+    plane.bakedOpacity = wgt->opacity();
+}
+
+void UIManager::softCompositePlane(const Widget *wgt, const SDL_Rect &dst, const SDL_Rect &area) {
+    auto it = softPlanes_.find(wgt);
+    if (it == softPlanes_.end() || !it->second.valid) return;
+
+    const SoftPlane &plane = it->second;
+    if (plane.solid) softCompositor_->blendColor(dst, area, plane.color, wgt->opacity());
+    else softCompositor_->blendImage(plane.image, dst.x, dst.y, area, plane.baked ? 255 : wgt->opacity());
+}
+
+void UIManager::softCompositeScreenArea(const SDL_Rect &area) {
+    softCompositor_->fill(area, DEFAULT_BACKGROUND_COLOR);
+
+    // same order as compositeScreenArea
+    auto compositeTop = [&](const Widget *top) {
+        softCompositePlane(top, top->rect(), area);
+
+        for (const LayerEntry &entry : layers_) {
+            if (entry.top != top) continue;
+
+            SDL_Rect dst, clip, visible;
+            if (!entry.layer->screenPlacement(dst, clip)) continue;
+            if (!SDL_IntersectRect(&clip, &area, &visible)) continue;
+
+            softCompositePlane(entry.layer, dst, visible);
+        }
+    };
+
+    if (wTreeRoot_) compositeTop(wTreeRoot_);
+    for (Widget *modalWgt : modalWidgets_) {
+        if (!modalWgt->isHiden()) compositeTop(modalWgt);
+    }
+}
+
+void UIManager::setSoftwareCompositing(bool enabled, SimdLevel level) {
+    if (enabled && softCompositor_) {
+        softCompositor_->setSimdLevel(level);
+        return;
+    }
+    if (!enabled && !softCompositor_) return;
+
+    if (enabled) softCompositor_ = std::make_unique<SoftCompositor>(0, 0, level);
+    else softCompositor_.reset();
+
+    // the frame texture changes its access, the mirrors are rebuilt on demand
+    if (frameTexture_) SDL_DestroyTexture(frameTexture_);
+    frameTexture_ = nullptr;
+    if (softScratch_) SDL_DestroyTexture(softScratch_);
+    softScratch_ = nullptr;
+    softPlanes_.clear();
+}
+
+void UIManager::renderPass() {
+    // user code may have used the renderer since the last frame
+    renderState_->forget();
+    if (layersDirty_) rebuildLayers();
+
+    if (wTreeRoot_) renderPlane(wTreeRoot_);
+
+    for (Widget *modalWgt : modalWidgets_)  {
+        if (modalWgt->isHiden()) continue;
+
+        renderPlane(modalWgt);
+    }
+
+    // layers do not dirty their parents, so the tree walk above may not have reached them
+    for (const LayerEntry &entry : layers_) {
+        SDL_Rect dst, clip;
+        if (entry.layer->screenPlacement(dst, clip)) renderPlane(entry.layer);
+    }
+
+    if (!frameTexture_) {
+        int width = 0, height = 0;
+        SDL_GetRendererOutputSize(renderer_, &width, &height);
+        SDL_TextureAccess access = softCompositor_ ? SDL_TEXTUREACCESS_STREAMING : SDL_TEXTUREACCESS_TARGET;
+        Uint32 format = softCompositor_ ? SDL_PIXELFORMAT_ARGB8888 : SDL_PIXELFORMAT_RGBA8888;
+        frameTexture_ = SDL_CreateTexture(renderer_, format, access, width, height);
+        assert(frameTexture_);
+
+        screenDamage_.setBounds(width, height);
+        if (softCompositor_) softCompositor_->resize(width, height);
+    }
+
+    if (!screenDamage_.empty() && softCompositor_) {
+        for (const Rect &area : screenDamage_.rects()) {
+            softCompositeScreenArea(area);
+            softCompositor_->upload(frameTexture_, area);
+        }
+        screenDamage_.clear();
+    }
+    else if (!screenDamage_.empty()) {
+        RenderStateScope stateScope(*renderState_);
+        renderState_->setTarget(frameTexture_);
+        renderState_->setViewport(nullptr);
+        renderState_->setBlendMode(SDL_BLENDMODE_BLEND);
+
+        for (const Rect &area : screenDamage_.rects()) compositeScreenArea(area);
+        screenDamage_.clear();
+    }
+
+    // back buffer content is undefined after present, the composed frame is always copied whole
+    renderState_->apply(RenderState::GEOMETRY);
+    SDL_RenderCopy(renderer_, frameTexture_, NULL, NULL);
 }
 
 void UIManager::run() {
@@ -271,21 +969,86 @@ void UIManager::run() {
 
     bool running = true;
     while (running) {
-        Uint32 frameStart = SDL_GetTicks();
+        // nothing changed last frame: sleep until the next event arrives
+        if (eventDriven_ && !frameActive_ && !needsPresent()) {
+            MYGUI_PROFILE_SCOPE("waitEvent");
+            Uint32 timeout = 0;
+            if (scheduler_->timeUntilNext(SDL_GetTicks64(), timeout)) {
+                if (timeout) SDL_WaitEventTimeout(nullptr, static_cast<int>(std::min<Uint32>(timeout, SDL_MAX_SINT32)));
+            }
+            else SDL_WaitEvent(nullptr);
+            pacer_.resume();
+        }
 
+        running = step();
+        pacer_.wait();
+    }
+}
+
+bool UIManager::step() {
+    MYGUI_PROFILE_FRAME_BEGIN();
+    bool running = true;
+    double ticksPerMs = SDL_GetPerformanceFrequency() / 1000.0;
+    Uint64 stageStart = SDL_GetPerformanceCounter();
+
+    auto stageEnd = [&](double &ms) {
+        Uint64 now = SDL_GetPerformanceCounter();
+        ms = (now - stageStart) / ticksPerMs;
+        stageStart = now;
+    };
+
+    pacer_.beginFrame();
+    frameTimings_ = {};
+    // the clock may stand since an idle wait, delays scheduled by the handlers count from now
+    bool timersRan;
+    {
+        MYGUI_PROFILE_SCOPE("advanceTimers");
+        timersRan = scheduler_->advance(SDL_GetTicks64()) > 0;
+    }
+    {
+        MYGUI_PROFILE_SCOPE("handleSDLEvents");
         handleSDLEvents(&running);
+    }
+    stageEnd(frameTimings_.eventsMs);
 
-        // updates
-        updatePass();
-        
-        // render 
-        SDL_SetRenderDrawColor(renderer_, 50, 50, 50, 255);
-        SDL_RenderClear(renderer_);
-        renderPass();
-        SDL_RenderPresent(renderer_);
+    // updates
+    {
+        MYGUI_PROFILE_SCOPE("drainPosted");
+        frameActive_ = drainPosted() || timersRan;
+    }
+    {
+        MYGUI_PROFILE_SCOPE("updatePass");
+        frameActive_ |= updatePass();
+    }
+    {
+        MYGUI_PROFILE_SCOPE("uploadAssets");
+        assetManager_->uploadPending(DEFAULT_ASSET_UPLOAD_BUDGET_MS);
+        frameActive_ |= assetManager_->hasPendingUploads();
+    }
+    stageEnd(frameTimings_.updateMs);
+
+    // late latch: the pointer as close to the present as possible, drags track the cursor
+    if (lateLatch_) {
+        MYGUI_PROFILE_SCOPE("latchPointer");
+        frameActive_ |= latchPointer();
+    }
+    stageEnd(frameTimings_.latchMs);
 
-        // frame pacing
-        Uint32 frameTime = SDL_GetTicks() - frameStart;
-        if (frameDelayMs_ > frameTime) SDL_Delay(frameDelayMs_ - frameTime);
+    // render 
+    if (!eventDriven_ || needsPresent()) {
+        {
+            MYGUI_PROFILE_SCOPE("renderPass");
+            renderPass();
+        }
+        stageEnd(frameTimings_.renderMs);
+        {
+            MYGUI_PROFILE_SCOPE("present");
+            SDL_RenderPresent(renderer_);
+        }
+        stageEnd(frameTimings_.presentMs);
+        frameTimings_.presented = true;
     }
+
+    MYGUI_PROFILE_FRAME_END();
+    return running;
 }
\ No newline at end of file
@@ -1,15 +1,82 @@
 #include "Widget.h"
 #include "Events.h"
+#include "UIManager.h"
+#include "RenderBatch.h"
+#include "Profiler.h"
+
+// a no-op unless a parallel update pass is running
+class Widget::TreeLock {
+    std::unique_lock<std::recursive_mutex> lock_;
+public:
+    explicit TreeLock(UIManager *manager) {
+        if (manager && manager->parallelUpdate()) lock_ = std::unique_lock<std::recursive_mutex>(manager->treeMutex());
+    }
+};
 
 Widget::Widget(int width, int height, Widget *parent)
-    : parent_(parent), rect_(0, 0, width, height)
+    : parent_(parent), rect_(0, 0, width, height), damage_(width, height)
 {}
 
 Widget::~Widget() {
-    if (texture_) {
-        SDL_DestroyTexture(texture_);
-        texture_ = nullptr;
+    if (UIManager_) {
+        UIManager_->animator().cancel(this);
+        UIManager_->forgetWidget(this);
+        if (layer_) UIManager_->layersChanged();
+    }
+    releaseTexture();
+}
+
+void Widget::acquireTexture(SDL_Renderer* renderer) {
+    assert(!texture_);
+
+    if (UIManager_) texture_ = UIManager_->texturePool().acquire(rect_.w, rect_.h);
+    else texture_ = SDL_CreateTexture(renderer,
+                                      SDL_PIXELFORMAT_RGBA8888,
+                                      SDL_TEXTUREACCESS_TARGET,
+                                      rect_.w, rect_.h);
+    assert(texture_);
+
+    // pooled textures hold stale pixels
+    damage_.addFull();
+}
+
+void Widget::releaseTexture() {
+    if (!texture_) return;
+
+    if (!UIManager_) SDL_DestroyTexture(texture_);
+    else if (inParallelUpdate()) {
+        // update tasks may run on workers, the pool and SDL are only touched by the UI thread
+        UIManager *manager = UIManager_;
+        SDL_Texture *texture = texture_;
+        manager->post([manager, texture] { manager->texturePool().release(texture); });
     }
+    else UIManager_->texturePool().release(texture_);
+    texture_ = nullptr;
+
+    needRerender_ = true;
+    damage_.addFull();
+}
+
+bool Widget::inParallelUpdate() const {
+    return UIManager_ && UIManager_->parallelUpdate();
+}
+
+void Widget::attachUIManager(UIManager *manager) {
+    if (UIManager_ != manager) {
+        releaseTexture(); // the texture belongs to the previous pool
+        if (UIManager_) {
+            UIManager_->animator().cancel(this);
+            UIManager_->forgetWidget(this);
+        }
+    }
+
+    // also called on reparenting, the paint order of the layers and the tab order may change
+    if (layer_ && UIManager_) UIManager_->layersChanged();
+    if (layer_ && manager) manager->layersChanged();
+    if (focusable_ && manager) manager->focusChainChanged();
+
+    UIManager_ = manager;
+    for (Widget *child : getChildren()) child->attachUIManager(manager);
 }
 
 void Widget::renderSelfAction(SDL_Renderer* renderer) {
@@ -20,36 +87,306 @@ void Widget::renderSelfAction(SDL_Renderer* renderer) {
     SDL_RenderFillRect(renderer, &full);
 }
 
+bool Widget::solidColor(SDL_Color &color) const {
+    if (!solidFill_) return false;
+
+    color = WHITE_SDL_COLOR;
+    return true;
+}
+
+void Widget::setSolidFill(bool solidFill) {
+    if (solidFill_ == solidFill) return;
+
+    solidFill_ = solidFill;
+    // composed by the parent instead of from a texture, or the other way around
+    releaseTexture();
+    needRerender_ = true;
+    damage_.addFull();
+    damageParent(rect_);
+}
+
+void Widget::setOpaque(bool opaque) {
+    if (opaque_ == opaque) return;
+
+    opaque_ = opaque;
+    damageParent(rect_); // the siblings underneath may have been skipped
+}
+
+bool Widget::isOpaque() const {
+    if (opacity_ != 255) return false;
+    if (opaque_) return true;
+
+    SDL_Color fill;
+    return solidColor(fill) && fill.a == 255;
+}
+
+bool Widget::keepsTexture() const {
+    SDL_Color fill;
+    return (layer_ || composition_ == CompositionPolicy::CACHED) && !isSolidLeaf(fill);
+}
+
+void Widget::finishDirectRender() {
+    // drawn straight into the parent's target by composeInto, nothing to keep
+    releaseTexture();
+    damage_.clear();
+    needRerender_ = false;
+}
+
+void Widget::setCompositionPolicy(CompositionPolicy policy) {
+    if (composition_ == policy) return;
+
+    composition_ = policy;
+    invalidate();
+}
+
+void Widget::composeSelf(SDL_Renderer* renderer, RenderBatch &batch, const SDL_Rect &dst, const SDL_Rect &clip) {
+    MYGUI_PROFILE_WIDGET_SCOPE("compose", this);
+    SDL_Color fill;
+    if (solidColor(fill)) {
+        fill.a = static_cast<Uint8>(fill.a * opacity_ / 255);
+        batch.fillRect(dst, fill);
+        return;
+    }
+
+    SDL_Rect visible;
+    if (!SDL_IntersectRect(&dst, &clip, &visible)) return;
+
+    // translated viewport, the clip rect is relative to it
+    batch.flush();
+    RenderState &state = batch.state();
+    state.setViewport(&dst);
+    SDL_Rect localClip = {visible.x - dst.x, visible.y - dst.y, visible.w, visible.h};
+    state.setClipRect(&localClip);
+    state.apply(RenderState::GEOMETRY);
+
+    renderSelfAction(renderer);
+    state.forgetDrawState();
+
+    state.setViewport(nullptr);
+    state.setClipRect(&clip);
+    state.setBlendMode(SDL_BLENDMODE_BLEND);
+}
+
+void Widget::composeInto(SDL_Renderer* renderer, RenderBatch &batch, const SDL_Rect &dst, const SDL_Rect &clip) {
+    if (!keepsTexture()) {
+        composeSelf(renderer, batch, dst, clip);
+        return;
+    }
+
+    if (texture_) batch.copy(texture_, textureRect(), dst, opacity_);
+}
+
 bool Widget::render(SDL_Renderer* renderer) {
     if (!needRerender_) return false;
+    MYGUI_PROFILE_WIDGET_SCOPE("render", this);
 
-    RendererGuard RendererGuard(renderer);
+    if (!keepsTexture()) {
+        finishDirectRender();
+        return true;
+    }
 
-    if (!texture_) texture_ = SDL_CreateTexture(renderer,
-                                 SDL_PIXELFORMAT_RGBA8888,
-                                 SDL_TEXTUREACCESS_TARGET,
-                                 rect_.w, rect_.h);
-    assert(texture_);
+    RenderState localState(renderer);
+    RenderState &state = UIManager_ ? UIManager_->renderState() : localState;
+    RenderStateScope stateScope(state);
+
+    if (!texture_) acquireTexture(renderer);
 
     SDL_SetTextureBlendMode(texture_, SDL_BLENDMODE_BLEND);
     SDL_SetTextureAlphaMod(texture_, 255);
 
-    SDL_SetRenderTarget(renderer, texture_);
-    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
-
-    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
-    SDL_RenderClear(renderer);
+    state.setTarget(texture_);
+    state.setViewport(nullptr); // the scope keeps the viewport of an enclosing compose
 
-    renderSelfAction(renderer);
+    for (const Rect &area : damage_.rects()) {
+        state.setClipRect(&area);
+        state.clearRect(area);
+        state.apply(RenderState::GEOMETRY);
+        renderSelfAction(renderer);
+        state.forgetDrawState();
+    }
 
+    damage_.clear();
     needRerender_ = false;
     return true;
 }
 
+void Widget::damageParent(const SDL_Rect &rect) {
+    TreeLock lock(UIManager_);
+    if (layer_ && parent_ && UIManager_) {
+        // layers are not part of the parent image, only the screen under them changes
+        SDL_Rect screen = rect;
+        for (const Widget *wgt = parent_; wgt; wgt = wgt->parent_) {
+            screen.x += wgt->rect_.x;
+            screen.y += wgt->rect_.y;
+        }
+        UIManager_->damageScreen(&screen);
+    }
+    else if (parent_) parent_->invalidate(&rect);
+    else if (UIManager_) UIManager_->damageScreen(&rect);
+}
+
+void Widget::restackImpl(Widget *child) {
+    if (child->layer_) {
+        if (child->UIManager_) child->UIManager_->layersChanged();
+        child->damageParent(child->rect_);
+    }
+    else {
+        Rect chldRect = child->rect_;
+        invalidate(&chldRect);
+    }
+}
+
+bool Widget::screenPlacement(SDL_Rect &dst, SDL_Rect &clip) const {
+    if (isHiden_) return false;
+
+    dst = rect_;
+    clip = rect_;
+    for (const Widget *wgt = parent_; wgt; wgt = wgt->parent_) {
+        if (wgt->isHiden_) return false;
+
+        SDL_Rect bounds = {0, 0, wgt->rect_.w, wgt->rect_.h};
+        if (!SDL_IntersectRect(&clip, &bounds, &clip)) return false;
+
+        dst.x += wgt->rect_.x;
+        dst.y += wgt->rect_.y;
+        clip.x += wgt->rect_.x;
+        clip.y += wgt->rect_.y;
+    }
+
+    return true;
+}
+
+void Widget::setLayer(bool layer) {
+    if (layer_ == layer) return;
+
+    damageParent(rect_); // through the old route
+    layer_ = layer;
+    damageParent(rect_);
+
+    releaseTexture();
+    needRerender_ = true;
+    damage_.addFull();
+    TreeLock lock(UIManager_);
+    if (UIManager_) UIManager_->layersChanged();
+}
+
+void Widget::setOpacity(Uint8 opacity) {
+    if (opacity_ == opacity) return;
+
+    opacity_ = opacity;
+    damageParent(rect_);
+}
+
+void Widget::setZOrder(int zOrder) {
+    if (zOrder_ == zOrder) return;
+
+    zOrder_ = zOrder;
+    TreeLock lock(UIManager_);
+    if (layer_ && UIManager_) UIManager_->layersChanged();
+    damageParent(rect_);
+}
+
+void Widget::invalidate(const SDL_Rect *rect) {
+    needRerender_ = true;
+    if (damage_.isFull()) return; // whole widget is already reported to the parent
+
+    Rect local(0, 0, rect_.w, rect_.h);
+    if (rect && !SDL_IntersectRect(rect, &local, &local)) return;
+
+    if (rect) damage_.add(local);
+    else damage_.addFull();
+
+    local.x += rect_.x;
+    local.y += rect_.y;
+    damageParent(local);
+}
+
+void Widget::setFocusable(bool focusable) {
+    if (focusable_ == focusable) return;
+
+    if (!focusable && hasFocus()) UIManager_->setFocus(nullptr);
+    focusable_ = focusable;
+    if (UIManager_) UIManager_->focusChainChanged();
+}
+
+void Widget::setTabIndex(int tabIndex) {
+    if (tabIndex_ == tabIndex) return;
+
+    tabIndex_ = tabIndex;
+    if (focusable_ && UIManager_) UIManager_->focusChainChanged();
+}
+
+bool Widget::hasFocus() const {
+    return UIManager_ && UIManager_->focused() == this;
+}
+
+void Widget::hide() {
+    if (isHiden_) return;
+    isHiden_ = true;
+    damageParent(rect_);
+    releaseSubtreeTextures();
+}
+
+void Widget::releaseSubtreeTextures() {
+    // cached and layer descendants keep targets of their own; the flag on every level
+    // lets the render walk reach them again once shown
+    releaseTexture();
+    needRerender_ = true;
+    for (Widget *child : getChildren()) child->releaseSubtreeTextures();
+}
+
+void Widget::show() {
+    if (!isHiden_) return;
+    isHiden_ = false;
+    damageParent(rect_);
+}
+
+void Widget::setPosition(int x, int y) {
+    if (rect_.x == x && rect_.y == y) return;
+
+    Rect oldRect = rect_;
+    damageParent(rect_);
+    rect_.x = x;
+    rect_.y = y;
+    damageParent(rect_);
+
+    TreeLock lock(UIManager_);
+    if (parent_) parent_->childRectChanged(this, oldRect);
+}
+
+void Widget::setSize(int w, int h) {
+    if (rect_.w == w && rect_.h == h) return;
+
+    Rect oldRect = rect_;
+    damageParent(rect_);
+    rect_.w = w;
+    rect_.h = h;
+    damage_.setBounds(w, h);
+    needRerender_ = true;
+    releaseTexture();
+    damageParent(rect_);
+
+    TreeLock lock(UIManager_);
+    if (parent_) parent_->childRectChanged(this, oldRect);
+}
+
+void Widget::setWantsUpdate(bool wants) {
+    if (wantsUpdate_ == wants) return;
+
+    // the parent drops idle children from its tick list by itself
+    wantsUpdate_ = wants;
+    TreeLock lock(UIManager_);
+    if (wants) enlistForUpdate();
+}
+
 bool Widget::updateSelfAction() { return false; }
-bool Widget::update() { return updateSelfAction(); }
+bool Widget::update() {
+    MYGUI_PROFILE_WIDGET_SCOPE("update", this);
+    return updateSelfAction();
+}
 
 bool Widget::onMouseWheel(const MouseWheelEvent &event) {
+    MYGUI_PROFILE_WIDGET_SCOPE("wheel", this);
     return onMouseWheelSelfAction(event);
 }
 bool Widget::onMouseDown(const MouseButtonEvent &event) {
@@ -68,9 +405,11 @@ bool Widget::onMouseMove(const MouseMotionEvent &event) {
     return onMouseMoveSelfAction(event);
 }
 bool Widget::onKeyDown(const KeyEvent &event) {
+    MYGUI_PROFILE_WIDGET_SCOPE("keyDown", this);
     return onKeyDownSelfAction(event); 
 }
 bool Widget::onKeyUp(const KeyEvent &event) {
+    MYGUI_PROFILE_WIDGET_SCOPE("keyUp", this);
     return onKeyUpSelfAction(event); 
 }
 
@@ -93,6 +432,18 @@ bool Widget::onKeyDownSelfAction(const KeyEvent &event) {
 bool Widget::onKeyUpSelfAction(const KeyEvent &event) {
     return PROPAGATE;
 }
+void Widget::onFocusSelfAction(bool focused) {
+}
+
+bool Widget::onMouseDownCapture(const MouseButtonEvent &event) {
+    return PROPAGATE;
+}
+bool Widget::onMouseUpCapture(const MouseButtonEvent &event) {
+    return PROPAGATE;
+}
+bool Widget::onMouseMoveCapture(const MouseMotionEvent &event) {
+    return PROPAGATE;
+}
 
 
 const std::vector<Widget *> &Widget::getChildren() const {
@@ -102,4 +453,5 @@ const std::vector<Widget *> &Widget::getChildren() const {
 
 Rect Widget::rect() const { return rect_; }
 const Widget *Widget::parent() const { return parent_; }
+Widget *Widget::parent() { return parent_; }
 SDL_Texture* Widget::texture() { return texture_; }
@@ -2,10 +2,22 @@
 #include "Events.h"
 #include "UIManager.h"
 
+bool Window::onMouseDownSelfAction(const MouseButtonEvent &event) {
+    if (event.button != SDL_BUTTON_LEFT) return PROPAGATE;
+    if (childAt(event.pos.x - rect_.x, event.pos.y - rect_.y)) return PROPAGATE;
+
+    UIManager_->capturePointer(this, event.button);
+    return CONSUME;
+}
+
 bool Window::onMouseMoveSelfAction(const MouseMotionEvent &event) {
     if (this == UIManager_->mouseActived() && event.button == SDL_BUTTON_LEFT) {
         accumulatedRel_ += event.rel;
         replaced_ = true;
+
+        // late in the frame, the update pass already ran
+        if (UIManager_->latchingPointer()) updateSelfAction();
+        else setWantsUpdate(true);
         return CONSUME;
     }
 
@@ -20,15 +32,21 @@ void Window::renderSelfAction(SDL_Renderer* renderer) {
     SDL_RenderFillRect(renderer, &widgetRect);
 }
 
+bool Window::solidColor(SDL_Color &color) const {
+    if (!solidFill_) return false;
+
+    color = DEFAULT_WINDOW_COLOR;
+    return true;
+}
+
 bool Window::updateSelfAction() {
     if (replaced_) {
-        rect_.x += accumulatedRel_.x;
-        rect_.y += accumulatedRel_.y;
+        setPosition(rect_.x + accumulatedRel_.x, rect_.y + accumulatedRel_.y);
         accumulatedRel_ = {0, 0};
         replaced_ = false;
-        if (parent_) parent_->invalidate();
-        return CONSUME;
+        setWantsUpdate(false);
+        return true;
     }
     
-    return PROPAGATE;
+    return false;
 }